@@ -0,0 +1,485 @@
+/*
+ * bench/average.cpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <tdap/average.hpp>
+#include <tdap/bucket-average.hpp>
+#include <tdap/perceptive-rms.hpp>
+
+/**
+ * Precision parameters per sample type: float needs fewer signal-noise-ratio
+ * bits and a smaller error mitigating decay to allow reasonable windows.
+ */
+template<typename S>
+struct Precision;
+
+template<>
+struct Precision<double>
+{
+    static constexpr size_t SNR_BITS = 20;
+    static constexpr size_t EMD_RATIO = 100;
+};
+
+template<>
+struct Precision<float>
+{
+    static constexpr size_t SNR_BITS = 10;
+    static constexpr size_t EMD_RATIO = 16;
+};
+
+template<typename S, bool POWER2_HISTORY = false>
+using Average = tdap::average::TrueFloatingPointWeightedMovingAverage<
+        S, Precision<S>::SNR_BITS, 10, POWER2_HISTORY>;
+
+template<typename S, bool POWER2_HISTORY = false>
+using AverageSet = tdap::average::TrueFloatingPointWeightedMovingAverageSet<
+        S, Precision<S>::SNR_BITS, 10, POWER2_HISTORY>;
+
+template<typename S, size_t CHANNELS>
+using MultiChannelAverage = tdap::average::MultiChannelMovingAverage<
+        S, CHANNELS, Precision<S>::SNR_BITS>;
+
+static constexpr size_t FRAMES = 1024;
+static constexpr size_t FIXED_WINDOW_SAMPLES = 4800;
+
+template<typename S>
+static std::vector<S> randomInput(size_t samples)
+{
+    std::mt19937 random(samples);
+    std::uniform_real_distribution<S> distribution(0.0, 1.0);
+    std::vector<S> input(samples);
+    for (S &value : input) {
+        value = distribution(random);
+    }
+    return input;
+}
+
+template<typename S>
+static size_t emdFor(size_t windowSamples)
+{
+    return Precision<S>::EMD_RATIO * windowSamples;
+}
+
+template<typename S, bool POWER2_HISTORY>
+static void averagePerSample(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    std::vector<S> input = randomInput<S>(FRAMES);
+    std::vector<S> output(FRAMES);
+    Average<S, POWER2_HISTORY> average(window, emdFor<S>(window));
+    average.setAverage(0);
+    for (auto _ : state) {
+        for (size_t i = 0; i < FRAMES; i++) {
+            average.addInput(input[i]);
+            output[i] = average.getAverage();
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * FRAMES);
+}
+
+template<typename S>
+static void averageBlock(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t frames = state.range(1);
+    std::vector<S> input = randomInput<S>(frames);
+    std::vector<S> output(frames);
+    Average<S> average(window, emdFor<S>(window));
+    average.setAverage(0);
+    for (auto _ : state) {
+        average.addInputs(input.data(), output.data(), frames);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+template<typename S>
+static void averageResynchronisingBlock(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t frames = state.range(1);
+    std::vector<S> input = randomInput<S>(frames);
+    std::vector<S> output(frames);
+    tdap::average::ResynchronisingMovingAverage<S> average(window);
+    for (auto _ : state) {
+        average.addInputs(input.data(), output.data(), frames);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+template<typename S, bool BLOCK>
+static void averageBucket(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t frames = state.range(1);
+    std::vector<S> input = randomInput<S>(frames);
+    std::vector<S> output(frames);
+    tdap::average::BucketAverage<S, 64> average;
+    average.setApproximateWindowSize(window);
+    for (auto _ : state) {
+        if constexpr (BLOCK) {
+            average.addInputs(input.data(), output.data(), frames);
+        }
+        else for (size_t i = 0; i < frames; i++) {
+            output[i] = average.addInputGetAverage(input[i]);
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+/**
+ * Detects with independent bucket averages per level, like the attic
+ * PerceptiveRms did, or with the structure of arrays of PerceptiveRms.
+ */
+template<size_t LEVELS, bool VECTORIZED>
+static void averagePerceptiveRms(benchmark::State &state)
+{
+    static constexpr size_t BUCKETS = 16;
+    static constexpr size_t FRAMES = 1024;
+    using Detector = tdap::average::PerceptiveRms<double, BUCKETS, LEVELS>;
+    std::vector<double> input = randomInput<double>(FRAMES);
+    for (double &value : input) {
+        value *= value;
+    }
+    std::vector<double> output(FRAMES);
+    Detector detector;
+    detector.configure(48000, 5.0, 4);
+    std::vector<tdap::average::BucketAverage<double, BUCKETS>> averages(LEVELS);
+    for (size_t level = 0; level < LEVELS; level++) {
+        const double scale = detector.getScale(level);
+        averages[level].setBucketSizeAndCount(detector.getBucketSize(level), detector.getBucketCount(level));
+        averages[level].setOutputScale(scale * scale);
+    }
+    tdap::integration::SmoothHoldMaxAttackRelease<double> follower(240, 10, 480);
+    for (auto _ : state) {
+        if constexpr (VECTORIZED) {
+            detector.addSquares(input.data(), output.data(), FRAMES);
+        }
+        else for (size_t i = 0; i < FRAMES; i++) {
+            double maximum = 0;
+            for (auto &average : averages) {
+                maximum = std::max(maximum, average.addInputGetAverage(input[i]));
+            }
+            output[i] = follower.integrate(sqrt(maximum));
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * FRAMES);
+}
+
+/**
+ * Detects one level for interleaved channels with a detector per channel
+ * and the maximum per frame, or with a linked detector.
+ */
+template<size_t CHANNELS, bool LINKED>
+static void averageLinkedPerceptiveRms(benchmark::State &state)
+{
+    static constexpr size_t FRAMES = 1024;
+    std::vector<double> input = randomInput<double>(FRAMES * CHANNELS);
+    std::vector<double> output(FRAMES);
+    tdap::average::LinkedPerceptiveRms<double, CHANNELS, 16, 16> linked;
+    linked.configure(48000, 5.0, 4);
+    std::vector<tdap::average::PerceptiveRms<double, 16, 16>> detectors(CHANNELS);
+    for (auto &detector : detectors) {
+        detector.configure(48000, 5.0, 4);
+    }
+    for (auto _ : state) {
+        if constexpr (LINKED) {
+            linked.addFrames(input.data(), output.data(), FRAMES);
+        }
+        else for (size_t frame = 0; frame < FRAMES; frame++) {
+            double maximum = 0;
+            for (size_t channel = 0; channel < CHANNELS; channel++) {
+                const double value = input[frame * CHANNELS + channel];
+                maximum = std::max(maximum, detectors[channel].addSquareGetDetection(value * value));
+            }
+            output[frame] = maximum;
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * FRAMES * CHANNELS);
+}
+
+template<typename S, bool POWER2_CAPACITY>
+static void averageFixedCapacityBlock(benchmark::State &state)
+{
+    const size_t frames = state.range(0);
+    std::vector<S> input = randomInput<S>(frames);
+    std::vector<S> output(frames);
+    tdap::average::FixedCapacityTrueFloatingPointWeightedMovingAverage<
+            S, FIXED_WINDOW_SAMPLES, Precision<S>::SNR_BITS, 10, POWER2_CAPACITY> average(
+            emdFor<S>(FIXED_WINDOW_SAMPLES));
+    average.setAverage(0);
+    for (auto _ : state) {
+        average.addInputs(input.data(), output.data(), frames);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+template<typename S, bool POWER2_HISTORY>
+static void averageSetGetMax(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t windows = state.range(1);
+    std::vector<S> input = randomInput<S>(FRAMES);
+    AverageSet<S, POWER2_HISTORY> set(window, emdFor<S>(window), windows, 0.0);
+    for (auto _ : state) {
+        S maximum = 0;
+        for (size_t i = 0; i < FRAMES; i++) {
+            maximum += set.addInputGetMax(input[i], 0.0);
+        }
+        benchmark::DoNotOptimize(maximum);
+    }
+    state.SetItemsProcessed(state.iterations() * FRAMES);
+}
+
+static constexpr size_t MULTI_RATE_WINDOWS = 8;
+static constexpr size_t MULTI_RATE_SHORT_SAMPLES = 480;
+static constexpr size_t MULTI_RATE_LONG_SAMPLES = 48000;
+static constexpr size_t MULTI_RATE_EMD = 10 * MULTI_RATE_LONG_SAMPLES;
+
+/**
+ * Runs 8 short windows up to 480 samples and 8 long windows up to 48000
+ * samples, all at full rate with a single set or, if DECIMATION is bigger
+ * than one, with the long windows decimated.
+ */
+template<size_t DECIMATION>
+static void averageMultiRateSetGetMax(benchmark::State &state)
+{
+    using Set = std::conditional_t<
+            DECIMATION == 1,
+            AverageSet<double, false>,
+            tdap::average::MultiRateMovingAverageSet<double, std::max(DECIMATION, size_t(2))>>;
+    std::unique_ptr<Set> set;
+    if constexpr (DECIMATION == 1) {
+        set.reset(new Set(MULTI_RATE_LONG_SAMPLES, MULTI_RATE_EMD, 2 * MULTI_RATE_WINDOWS, 0.0));
+    }
+    else {
+        set.reset(new Set(MULTI_RATE_SHORT_SAMPLES, MULTI_RATE_LONG_SAMPLES, MULTI_RATE_EMD,
+                          MULTI_RATE_WINDOWS, MULTI_RATE_WINDOWS, 0.0));
+    }
+    for (size_t i = 0; i < MULTI_RATE_WINDOWS; i++) {
+        set->setWindowSizeAndScale(i, (i + 1) * MULTI_RATE_SHORT_SAMPLES / MULTI_RATE_WINDOWS, 1.0);
+        set->setWindowSizeAndScale(
+                MULTI_RATE_WINDOWS + i, (i + 1) * MULTI_RATE_LONG_SAMPLES / MULTI_RATE_WINDOWS, 1.0);
+    }
+    std::vector<double> input = randomInput<double>(FRAMES);
+    for (auto _ : state) {
+        double maximum = 0;
+        for (size_t i = 0; i < FRAMES; i++) {
+            maximum += set->addInputGetMax(input[i], 0.0);
+        }
+        benchmark::DoNotOptimize(maximum);
+    }
+    state.SetItemsProcessed(state.iterations() * FRAMES);
+}
+
+static void averagePreciseSetGetMax(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t windows = state.range(1);
+    std::mt19937 random(window);
+    std::uniform_int_distribution<int32_t> distribution(-(1 << 23), (1 << 23) - 1);
+    std::vector<int32_t> input(FRAMES);
+    for (int32_t &value : input) {
+        value = distribution(random);
+    }
+    tdap::average::PreciseWindowAverageSet<> set(window, windows, 0);
+    for (auto _ : state) {
+        double maximum = 0;
+        for (size_t i = 0; i < FRAMES; i++) {
+            maximum += set.addInputGetMax(input[i], 0.0);
+        }
+        benchmark::DoNotOptimize(maximum);
+    }
+    state.SetItemsProcessed(state.iterations() * FRAMES);
+}
+
+/**
+ * Adds blocks of 64 samples and then queries the given number of windows.
+ */
+static void averageWindowSumTreeQueries(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t windows = state.range(1);
+    const size_t block = 64;
+    std::vector<double> input = randomInput<double>(FRAMES);
+    tdap::average::WindowSumTree<double> tree(window);
+    for (auto _ : state) {
+        double maximum = 0;
+        for (size_t i = 0; i < FRAMES; i += block) {
+            tree.addInputs(input.data() + i, block);
+            for (size_t w = 1; w <= windows; w++) {
+                maximum = std::max(maximum, tree.getAverage(w * window / windows));
+            }
+        }
+        benchmark::DoNotOptimize(maximum);
+    }
+    state.SetItemsProcessed(state.iterations() * FRAMES);
+}
+
+/**
+ * Adds samples and reads the maximum of all windows about 30 times per second
+ * at 48kHz, like a meter does.
+ */
+template<typename S, bool LAZY>
+static void averageSetMetering(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t windows = state.range(1);
+    const size_t frames = 1600;
+    std::vector<S> input = randomInput<S>(frames);
+    using Set = std::conditional_t<
+            LAZY,
+            tdap::average::LazyTrueFloatingPointWeightedMovingAverageSet<S, Precision<S>::SNR_BITS, 10>,
+            AverageSet<S>>;
+    Set set(window, emdFor<S>(window), windows, 0.0);
+    for (auto _ : state) {
+        S maximum;
+        if constexpr (LAZY) {
+            set.addInputs(input.data(), frames);
+            maximum = set.getMaximum(0.0);
+        }
+        else {
+            for (size_t i = 0; i < frames; i++) {
+                set.addInput(input[i]);
+            }
+            maximum = set.addInputGetMax(0.0, 0.0);
+        }
+        benchmark::DoNotOptimize(maximum);
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+template<typename S, size_t CHANNELS>
+static void averagePerChannel(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t frames = 256;
+    std::vector<S> input = randomInput<S>(frames * CHANNELS);
+    std::vector<S> output(frames * CHANNELS);
+    std::vector<std::unique_ptr<Average<S>>> averages;
+    for (size_t channel = 0; channel < CHANNELS; channel++) {
+        averages.emplace_back(new Average<S>(window, emdFor<S>(window)));
+        averages.back()->setAverage(0);
+    }
+    for (auto _ : state) {
+        for (size_t frame = 0; frame < frames; frame++) {
+            for (size_t channel = 0; channel < CHANNELS; channel++) {
+                Average<S> &average = *averages[channel];
+                average.addInput(input[frame * CHANNELS + channel]);
+                output[frame * CHANNELS + channel] = average.getAverage();
+            }
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames * CHANNELS);
+}
+
+template<typename S, size_t CHANNELS>
+static void averageMultiChannel(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t frames = 256;
+    std::vector<S> input = randomInput<S>(frames * CHANNELS);
+    std::vector<S> output(frames * CHANNELS);
+    MultiChannelAverage<S, CHANNELS> average(window, emdFor<S>(window));
+    for (auto _ : state) {
+        average.addFrames(input.data(), output.data(), frames);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames * CHANNELS);
+}
+
+template<typename S, size_t CHANNELS>
+static void averageCompensatedMultiChannel(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t frames = 256;
+    std::vector<S> input = randomInput<S>(frames * CHANNELS);
+    std::vector<S> output(frames * CHANNELS);
+    tdap::average::CompensatedMultiChannelMovingAverage<S, CHANNELS> average(window);
+    for (auto _ : state) {
+        average.addFrames(input.data(), output.data(), frames);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames * CHANNELS);
+}
+
+static void windowSizes(benchmark::internal::Benchmark *benchmark)
+{
+    benchmark->Arg(64)->Arg(1024)->Arg(4800);
+}
+
+static void windowAndBlockSizes(benchmark::internal::Benchmark *benchmark)
+{
+    benchmark->ArgsProduct({{64, 1024, 4800}, {64, 1024}});
+}
+
+static void windowSizesAndCounts(benchmark::internal::Benchmark *benchmark)
+{
+    benchmark->ArgsProduct({{1024, 4800}, {4, 16, 32}});
+}
+
+BENCHMARK_TEMPLATE(averagePerSample, double, false)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averagePerSample, double, true)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averagePerSample, float, false)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averageBlock, double)->Apply(windowAndBlockSizes);
+BENCHMARK_TEMPLATE(averageBlock, float)->Apply(windowAndBlockSizes);
+BENCHMARK_TEMPLATE(averageResynchronisingBlock, double)->Apply(windowAndBlockSizes);
+BENCHMARK_TEMPLATE(averageBucket, double, false)->Apply(windowAndBlockSizes);
+BENCHMARK_TEMPLATE(averageBucket, double, true)->Apply(windowAndBlockSizes);
+BENCHMARK_TEMPLATE(averagePerceptiveRms, 8, false);
+BENCHMARK_TEMPLATE(averagePerceptiveRms, 8, true);
+BENCHMARK_TEMPLATE(averagePerceptiveRms, 16, false);
+BENCHMARK_TEMPLATE(averagePerceptiveRms, 16, true);
+BENCHMARK_TEMPLATE(averageLinkedPerceptiveRms, 2, false);
+BENCHMARK_TEMPLATE(averageLinkedPerceptiveRms, 2, true);
+BENCHMARK_TEMPLATE(averageLinkedPerceptiveRms, 8, false);
+BENCHMARK_TEMPLATE(averageLinkedPerceptiveRms, 8, true);
+BENCHMARK_TEMPLATE(averageFixedCapacityBlock, double, false)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(averageFixedCapacityBlock, double, true)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(averageSetGetMax, double, false)->Apply(windowSizesAndCounts);
+BENCHMARK_TEMPLATE(averageSetGetMax, double, true)->Apply(windowSizesAndCounts);
+BENCHMARK_TEMPLATE(averageSetGetMax, float, false)->Apply(windowSizesAndCounts);
+BENCHMARK_TEMPLATE(averageMultiRateSetGetMax, 1);
+BENCHMARK_TEMPLATE(averageMultiRateSetGetMax, 16);
+BENCHMARK_TEMPLATE(averageMultiRateSetGetMax, 64);
+BENCHMARK(averagePreciseSetGetMax)->Apply(windowSizesAndCounts);
+BENCHMARK_TEMPLATE(averageSetMetering, double, false)->Apply(windowSizesAndCounts);
+BENCHMARK_TEMPLATE(averageSetMetering, double, true)->Apply(windowSizesAndCounts);
+BENCHMARK(averageWindowSumTreeQueries)->ArgsProduct({{4800}, {32, 256}});
+BENCHMARK_TEMPLATE(averagePerChannel, double, 2)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averageMultiChannel, double, 2)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averagePerChannel, double, 8)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averageMultiChannel, double, 8)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averageMultiChannel, float, 8)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averageCompensatedMultiChannel, float, 8)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averageCompensatedMultiChannel, double, 8)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averagePerChannel, double, 64)->Apply(windowSizes);
+BENCHMARK_TEMPLATE(averageMultiChannel, double, 64)->Apply(windowSizes);
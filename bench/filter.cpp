@@ -0,0 +1,219 @@
+/*
+ * bench/filter.cpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <tdap/biquad.hpp>
+#include <tdap/filter-chain.hpp>
+#include <tdap/filter-analysis.hpp>
+
+template<typename T>
+using BiquadOf = tdap::filter::Biquad<T>;
+
+template<typename T>
+using BiquadChainOf = tdap::filter::FilterChain<
+        T, BiquadOf<T>, BiquadOf<T>, BiquadOf<T>, BiquadOf<T>, BiquadOf<T>>;
+
+using Biquad = BiquadOf<double>;
+using Filter = tdap::filter::Filter<double>;
+using BiquadAdapter = tdap::filter::FilterAdapter<double, Biquad>;
+
+static constexpr size_t BLOCK_SAMPLES = 1024;
+
+template<typename T = double>
+static std::vector<BiquadOf<T>> createBiquads(double sampleRate)
+{
+    return {
+            BiquadOf<T>::highPass(sampleRate, 20, 0.7),
+            BiquadOf<T>::peaking(sampleRate, 100, 1.0, 3.0),
+            BiquadOf<T>::peaking(sampleRate, 1000, 2.0, -3.0),
+            BiquadOf<T>::peaking(sampleRate, 5000, 1.0, 2.0),
+            BiquadOf<T>::lowPass(sampleRate, 18000, 0.7)
+    };
+}
+
+template<typename T>
+static std::vector<T> randomInput(size_t samples)
+{
+    std::mt19937 random(samples);
+    std::uniform_real_distribution<T> distribution(-1.0, 1.0);
+    std::vector<T> input(samples);
+    for (T &value : input) {
+        value = distribution(random);
+    }
+    return input;
+}
+
+template<typename T>
+static void biquadChainVirtual(benchmark::State &state)
+{
+    std::vector<T> input = randomInput<T>(BLOCK_SAMPLES);
+    std::vector<T> output(BLOCK_SAMPLES);
+    std::vector<std::unique_ptr<tdap::filter::Filter<T>>> chain;
+    for (const BiquadOf<T> &biquad : createBiquads<T>(state.range(0))) {
+        chain.emplace_back(new tdap::filter::FilterAdapter<T, BiquadOf<T>>(biquad));
+    }
+    for (auto _ : state) {
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            T value = input[i];
+            for (auto &filter : chain) {
+                value = filter->filter(value);
+            }
+            output[i] = value;
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * BLOCK_SAMPLES);
+}
+
+template<typename T>
+static void biquadChainVirtualBlock(benchmark::State &state)
+{
+    std::vector<T> input = randomInput<T>(BLOCK_SAMPLES);
+    std::vector<T> output(BLOCK_SAMPLES);
+    std::vector<std::unique_ptr<tdap::filter::Filter<T>>> chain;
+    for (const BiquadOf<T> &biquad : createBiquads<T>(state.range(0))) {
+        chain.emplace_back(new tdap::filter::FilterAdapter<T, BiquadOf<T>>(biquad));
+    }
+    for (auto _ : state) {
+        const T *source = input.data();
+        for (auto &filter : chain) {
+            filter->filter(source, output.data(), BLOCK_SAMPLES);
+            source = output.data();
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * BLOCK_SAMPLES);
+}
+
+template<typename T>
+static void biquadChainStatic(benchmark::State &state)
+{
+    std::vector<T> input = randomInput<T>(BLOCK_SAMPLES);
+    std::vector<T> output(BLOCK_SAMPLES);
+    std::vector<BiquadOf<T>> biquads = createBiquads<T>(state.range(0));
+    BiquadChainOf<T> chain(biquads[0], biquads[1], biquads[2], biquads[3], biquads[4]);
+    for (auto _ : state) {
+        for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+            output[i] = chain.filter(input[i]);
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * BLOCK_SAMPLES);
+}
+
+/**
+ * A chain of filters that is only known at runtime.
+ */
+class RuntimeChain : public Filter
+{
+    std::vector<std::unique_ptr<Filter>> filters_;
+public:
+    explicit RuntimeChain(const std::vector<Biquad> &biquads)
+    {
+        for (const Biquad &biquad : biquads) {
+            filters_.emplace_back(new BiquadAdapter(biquad));
+        }
+    }
+
+    double filter(const double input) override
+    {
+        double value = input;
+        for (auto &filter : filters_) {
+            value = filter->filter(value);
+        }
+        return value;
+    }
+
+    void filter(const double *input, double *output, size_t samples) override
+    {
+        for (auto &filter : filters_) {
+            filter->filter(input, output, samples);
+            input = output;
+        }
+    }
+
+    void reset() override
+    {
+        for (auto &filter : filters_) {
+            filter->reset();
+        }
+    }
+
+    double getMaximumPoleRadius() const override
+    {
+        double radius = 0;
+        for (auto &filter : filters_) {
+            radius = std::max(radius, filter->getMaximumPoleRadius());
+        }
+        return radius;
+    }
+};
+
+template<bool FAST>
+static void impulseResponseLength(benchmark::State &state)
+{
+    std::vector<Biquad> biquads = createBiquads(48000);
+    biquads.push_back(Biquad::peaking(48000, 40, state.range(0), 6.0));
+    RuntimeChain chain(biquads);
+    ssize_t length = 0;
+    for (auto _ : state) {
+        chain.reset();
+        length = FAST ?
+                Filter::getEffectiveImpulseResponseLengthFast(chain, 10000000, 1e-6, 100) :
+                Filter::getEffectiveImpulseResponseLength(chain, 10000000, 1e-6, 100);
+        benchmark::DoNotOptimize(length);
+    }
+    state.counters["length"] = length;
+}
+
+static void impulseResponseLengthsOfBank(benchmark::State &state)
+{
+    std::vector<std::unique_ptr<BiquadAdapter>> bank;
+    std::vector<const Filter *> filters;
+    for (size_t i = 0; i < 128; i++) {
+        bank.emplace_back(new BiquadAdapter(Biquad::peaking(48000, 40 + 40 * i, 10, 6.0)));
+        filters.push_back(bank.back().get());
+    }
+    tdap::filter::FilterClone<double> clone = [](const Filter &filter) {
+        return std::unique_ptr<Filter>(
+                new BiquadAdapter(static_cast<const BiquadAdapter &>(filter)));
+    };
+    for (auto _ : state) {
+        auto lengths = tdap::filter::getEffectiveImpulseResponseLengths(
+                filters, clone, 10000000, 1e-6, 100, state.range(0));
+        benchmark::DoNotOptimize(lengths.data());
+    }
+    state.SetItemsProcessed(state.iterations() * filters.size());
+}
+
+BENCHMARK_TEMPLATE(biquadChainVirtual, double)->Arg(48000)->Arg(192000);
+BENCHMARK_TEMPLATE(biquadChainVirtualBlock, double)->Arg(48000)->Arg(192000);
+BENCHMARK_TEMPLATE(biquadChainStatic, double)->Arg(48000)->Arg(192000);
+BENCHMARK_TEMPLATE(biquadChainVirtual, float)->Arg(48000)->Arg(192000);
+BENCHMARK_TEMPLATE(biquadChainVirtualBlock, float)->Arg(48000)->Arg(192000);
+BENCHMARK_TEMPLATE(biquadChainStatic, float)->Arg(48000)->Arg(192000);
+BENCHMARK_TEMPLATE(impulseResponseLength, false)->Arg(1)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(impulseResponseLength, true)->Arg(1)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK(impulseResponseLengthsOfBank)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond)->UseRealTime();
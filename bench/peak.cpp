@@ -0,0 +1,154 @@
+/*
+ * bench/peak.cpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <tdap/average.hpp>
+#include <tdap/limiter.hpp>
+#include <tdap/sliding-extremum.hpp>
+
+template<typename S>
+static void slidingWindowMax(benchmark::State &state)
+{
+    const size_t window = state.range(0);
+    const size_t frames = state.range(1);
+    std::mt19937 random(frames);
+    std::uniform_real_distribution<S> distribution(-1.0, 1.0);
+    std::vector<S> input(frames);
+    for (S &value : input) {
+        value = distribution(random);
+    }
+    std::vector<S> output(frames);
+    tdap::peak::SlidingWindowMax<S> maximum(window);
+    for (auto _ : state) {
+        maximum.addInputs(input.data(), output.data(), frames);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+BENCHMARK_TEMPLATE(slidingWindowMax, double)->ArgsProduct({{64, 480, 4800}, {1024}});
+BENCHMARK_TEMPLATE(slidingWindowMax, float)->ArgsProduct({{64, 480, 4800}, {1024}});
+
+/**
+ * A look-ahead limiter assembled from separate stages, as it was done before
+ * LookAheadLimiter: a delay object per channel, a sliding minimum of the
+ * needed gain, a decaying moving average for smoothing and intermediate
+ * buffers between stages.
+ */
+template<typename S, size_t CHANNELS>
+class AssembledLimiter
+{
+    class Delay
+    {
+        std::vector<S> buffer_;
+        size_t ptr_ = 0;
+    public:
+        explicit Delay(size_t samples) : buffer_(samples, 0) {}
+
+        S delay(S input)
+        {
+            S result = buffer_[ptr_];
+            buffer_[ptr_] = input;
+            ptr_ = ptr_ + 1 < buffer_.size() ? ptr_ + 1 : 0;
+            return result;
+        }
+    };
+
+    std::vector<Delay> delays_;
+    tdap::peak::SlidingWindowMin<double> minimum_;
+    tdap::average::TrueFloatingPointWeightedMovingAverage<double> average_;
+    std::vector<double> gains_;
+    double threshold_;
+
+public:
+    AssembledLimiter(size_t lookAhead, double threshold, size_t maxFrames) :
+            delays_(CHANNELS, Delay(lookAhead)),
+            minimum_(lookAhead + 1),
+            average_(lookAhead, 100 * lookAhead),
+            gains_(maxFrames),
+            threshold_(threshold)
+    {
+        minimum_.setValue(1);
+        average_.setAverage(1);
+    }
+
+    void process(const S *input, S *output, size_t frames)
+    {
+        for (size_t frame = 0; frame < frames; frame++) {
+            double peak = 0;
+            for (size_t channel = 0; channel < CHANNELS; channel++) {
+                peak = std::max(peak, static_cast<double>(fabs(input[frame * CHANNELS + channel])));
+            }
+            gains_[frame] = peak > threshold_ ? threshold_ / peak : 1.0;
+        }
+        for (size_t frame = 0; frame < frames; frame++) {
+            gains_[frame] = minimum_.addInput(gains_[frame]);
+        }
+        for (size_t frame = 0; frame < frames; frame++) {
+            average_.addInput(gains_[frame]);
+            gains_[frame] = average_.getAverage();
+        }
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            for (size_t frame = 0; frame < frames; frame++) {
+                const size_t i = frame * CHANNELS + channel;
+                output[i] = static_cast<S>(gains_[frame] * delays_[channel].delay(input[i]));
+            }
+        }
+    }
+};
+
+template<typename S, size_t CHANNELS, bool FUSED>
+static void lookAheadLimiter(benchmark::State &state)
+{
+    const size_t lookAhead = state.range(0);
+    const size_t frames = 256;
+    std::mt19937 random(lookAhead);
+    std::uniform_real_distribution<S> distribution(-2.0, 2.0);
+    std::vector<S> input(frames * CHANNELS);
+    for (S &value : input) {
+        value = distribution(random);
+    }
+    std::vector<S> output(frames * CHANNELS);
+    using Limiter = std::conditional_t<
+            FUSED, tdap::peak::LookAheadLimiter<S, CHANNELS>, AssembledLimiter<S, CHANNELS>>;
+    std::unique_ptr<Limiter> limiter;
+    if constexpr (FUSED) {
+        limiter.reset(new Limiter(lookAhead));
+        limiter->setThreshold(1.0);
+    }
+    else {
+        limiter.reset(new Limiter(lookAhead, 1.0, frames));
+    }
+    for (auto _ : state) {
+        limiter->process(input.data(), output.data(), frames);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+
+BENCHMARK_TEMPLATE(lookAheadLimiter, double, 2, false)->Arg(64)->Arg(480);
+BENCHMARK_TEMPLATE(lookAheadLimiter, double, 2, true)->Arg(64)->Arg(480);
+BENCHMARK_TEMPLATE(lookAheadLimiter, float, 8, false)->Arg(64)->Arg(480);
+BENCHMARK_TEMPLATE(lookAheadLimiter, float, 8, true)->Arg(64)->Arg(480);
@@ -36,31 +36,35 @@
  * type also forces an upper boundary or the average looses correlation with the
  * input samples.
  */
+#include <cstdint>
+#include <tdap/buffer.hpp>
 #include <tdap/impl/average-helper.hpp>
+#include <tdap/triple-buffer.hpp>
 
 namespace tdap::average
 {
     using namespace std;
     using namespace tdap::boundaries;
 
-    template<typename S, size_t SNR_BITS = 20, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO=10>
+    /**
+     * Implements a true windowed average on a history with a maximum window
+     * size that is set at construction.
+     *
+     * @tparam S the type of samples used, normally "double"
+     * @tparam POWER2_HISTORY whether the active history is a power of two, so
+     * that history pointers wrap around with a mask
+     */
+    template<typename S, size_t SNR_BITS = 20, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO=10, bool POWER2_HISTORY = false>
     class TrueFloatingPointWeightedMovingAverage
     {
         using History =
         helper::HistoryAndEmdForTrueFloatingPointMovingAverage
-                <S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>;
-        using Window = helper::WindowForTrueFloatingPointMovingAverage<S>;
+                <S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>;
+        using Window = helper::WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>;
 
         History history;
         Window window;
 
-        void optimiseForMaximumSamples()
-        {
-            if (history.optimiseForMaximumWindowSamples(window.windowSamples())) {
-                window.setReadPtr();
-            }
-        }
-
     public:
         using Metrics =
                 helper::HelperForMovingAverageMetricsForInaccurateTypes<
@@ -73,8 +77,34 @@ namespace tdap::average
 
         void setWindowSize(const size_t windowSamples);
 
+        /**
+         * Glides the window size to windowSamples over rampSamples samples,
+         * instead of jumping to it like setWindowSize(). While ramping, the
+         * window size is adjusted by addInput() for each sample and by
+         * addInputs() once per block, where the average is corrected for the
+         * history values that enter or leave the window. This avoids the
+         * level jumps and the error that an immediate change causes.
+         *
+         * Unlike setWindowSize(), this never makes the history that is in use
+         * smaller, so a window can later glide back to a bigger size with the
+         * correct history values. Use a rampSamples of zero to change the
+         * window size immediately while keeping the history.
+         */
+        void rampWindowSize(const size_t windowSamples, const size_t rampSamples);
+
+        size_t getWindowSize() const { return window.windowSamples(); }
+
         void addInput(const double input);
 
+        /**
+         * Adds a block of inputs and writes the average after each input to
+         * output, which may be the same as input. The block is split where the
+         * history wraps around, so the inner loops have no wrap checks. The
+         * results are identical to calling addInput() for each sample, unless
+         * the window size is ramping.
+         */
+        void addInputs(const S *input, S *output, size_t samples);
+
         const S getAverage() const { return window.getAverage(); }
 
         const size_t getReadPtr() const { return window.getReadPtr(); }
@@ -102,18 +132,20 @@ namespace tdap::average
      * @tparam S the type of samples used, normally "double"
      * @tparam MAX_SAMPLE_HISTORY the maximum sample history, determining the maximum RMS window size
      * @tparam MAX_RCS the maximum number of characteristic times in this array
+     * @tparam POWER2_HISTORY whether the active history is a power of two, so
+     * that history pointers wrap around with a mask
      */
-    template<typename S, size_t SNR_BITS = 20, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO=10>
+    template<typename S, size_t SNR_BITS = 20, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO=10, bool POWER2_HISTORY = false>
     class TrueFloatingPointWeightedMovingAverageSet
     {
         using History =
         helper::HistoryAndEmdForTrueFloatingPointMovingAverage
-                <S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>;
-        using Window =
-        helper::ScaledWindowForTrueFloatingPointMovingAverage<S>;
-
+                <S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>;
         static constexpr size_t MINIMUM_TIME_CONSTANTS = 1;
         static constexpr size_t MAXIMUM_TIME_CONSTANTS = 32;
+
+        using Windows =
+        helper::ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAXIMUM_TIME_CONSTANTS, POWER2_HISTORY>;
         static constexpr const char * TIME_CONSTANT_MESSAGE =
                 "The (maximum) number of time-constants must lie between "
         TDAP_QUOTE(MINIMUM_TIME_CONSTANTS) " and "
@@ -123,16 +155,33 @@ namespace tdap::average
         helper::HelperForMovingAverageMetricsForInaccurateTypes<
                 S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>;
 
+    public:
+        /**
+         * Window configuration with pre-calculated factors, that is prepared
+         * by a control thread and adopted by the processing thread.
+         */
+        struct Parameters
+        {
+            size_t usedWindows;
+            size_t windowSamples[MAXIMUM_TIME_CONSTANTS];
+            S scale[MAXIMUM_TIME_CONSTANTS];
+            S inputFactor[MAXIMUM_TIME_CONSTANTS];
+            S historyFactor[MAXIMUM_TIME_CONSTANTS];
+        };
+
+    private:
         const size_t entries_;
-        Window *entry_;
         size_t usedWindows_;
         History history_;
+        Windows windows_;
+        Parameters draft_;
+        TripleBuffer<Parameters> parameters_;
 
         static size_t validMaxTimeConstants(size_t constants);
 
         size_t checkWindowIndex(size_t index) const;
 
-        void optimiseForMaximumSamples();
+        bool optimiseForMaximumSamples();
 
     public:
 
@@ -143,8 +192,19 @@ namespace tdap::average
         size_t getUsedWindows() const { return usedWindows_; }
         size_t getMaxWindowSamples() const { return history_.historySize(); }
 
+        /**
+         * Sets the number of used windows. This must not be called while
+         * another thread adds input: use prepareUsedWindows() instead. The
+         * prepared parameters are not affected.
+         */
         void setUsedWindows(size_t windows);
 
+        /**
+         * Sets the window size and scale of the window with the given index.
+         * This must not be called while another thread adds input: use
+         * prepareWindowSizeAndScale() instead. The prepared parameters are
+         * not affected.
+         */
         void setWindowSizeAndScale(size_t index, size_t windowSamples, S scale);
 
         void setAverages(S average);
@@ -163,9 +223,728 @@ namespace tdap::average
 
         size_t getWritePtr() const { return history_.writePtr(); }
 
-        size_t getReadPtr(size_t i) const { return entry_[i].getReadPtr(); }
+        size_t getReadPtr(size_t i) const { return windows_.getReadPtr(i); }
+
+        /**
+         * Prepares a new window size and scale for the window with the given
+         * index, that is adopted after publishParameters() and
+         * adoptParameters(). This, prepareUsedWindows() and
+         * publishParameters() can be called from a single control thread,
+         * while another thread processes samples.
+         */
+        void prepareWindowSizeAndScale(size_t index, size_t windowSamples, S scale);
+
+        /**
+         * Prepares a new number of used windows.
+         * @see prepareWindowSizeAndScale()
+         */
+        void prepareUsedWindows(size_t windows);
+
+        /**
+         * Publishes all prepared parameters, without locking.
+         */
+        void publishParameters();
+
+        /**
+         * Adopts the most recently published parameters if they were not
+         * adopted yet, and returns whether that happened. This does not lock
+         * or allocate and should be called by the processing thread, for
+         * example at the start of each block.
+         */
+        bool adoptParameters();
+    };
+
+    /**
+     * Implements the same set of weighted moving averages as
+     * TrueFloatingPointWeightedMovingAverageSet, but only calculates the
+     * averages when they are queried. This suits windows that are read far
+     * less often than samples arrive, like those of meters.
+     *
+     * Instead of samples, the history contains the decayed sum of all
+     * samples so far, D(t) = emdFactor * D(t - 1) + x(t). The average of a
+     * window of W samples is inputFactor * (D(t) - emdFactor^W * D(t - W)),
+     * which is inputFactor * D(t) - historyFactor * D(t - W). This is
+     * exactly what the set calculates by running, so adding a sample costs
+     * a single multiply-add, regardless of the number of windows. Changes of
+     * window size take effect immediately and exactly.
+     *
+     * As D is about the error mitigating decay divided by the window size
+     * bigger than the sum of a window, the difference loses some precision,
+     * which limits the ratio of error mitigating decay to the smallest
+     * window. Window sizes below getMinimumWindowSamples() are rejected, as
+     * their averages would not have SNR_BITS of precision. With double
+     * samples, that is only a limit for extremely long decays.
+     *
+     * @tparam S the type of samples used, normally "double"
+     */
+    template<typename S, size_t SNR_BITS = 20, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO=10>
+    class LazyTrueFloatingPointWeightedMovingAverageSet
+    {
+        using History =
+        helper::HistoryAndEmdForTrueFloatingPointMovingAverage
+                <S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>;
+        static constexpr size_t MINIMUM_TIME_CONSTANTS = 1;
+        static constexpr size_t MAXIMUM_TIME_CONSTANTS = 32;
+        static constexpr const char * TIME_CONSTANT_MESSAGE =
+                "The (maximum) number of time-constants must lie between "
+        TDAP_QUOTE(MINIMUM_TIME_CONSTANTS) " and "
+        TDAP_QUOTE(MAXIMUM_TIME_CONSTANTS) ".";
+
+        // Measured relative error of an average in units of epsilon times
+        // the ratio of error mitigating decay to window size, rounded up,
+        // and the same for the part that only depends on the decay
+        static constexpr double DIFFERENCE_ERROR = 64;
+        static constexpr double DECAY_ERROR = 1;
+
+        const size_t entries_;
+        size_t usedWindows_;
+        History history_;
+        const size_t minimumWindowSamples_;
+        S decayedSum_ = 0;
+        size_t windowSamples_[MAXIMUM_TIME_CONSTANTS];
+        S scale_[MAXIMUM_TIME_CONSTANTS];
+        S inputFactor_[MAXIMUM_TIME_CONSTANTS];
+        S historyFactor_[MAXIMUM_TIME_CONSTANTS];
+
+        static size_t validMaxTimeConstants(size_t constants);
+
+        static size_t validMinimumWindowSamples(size_t emdSamples, size_t maxWindowSamples);
+
+        size_t checkWindowIndex(size_t index) const;
+
+        S getUnscaledAverage(size_t index) const
+        {
+            return inputFactor_[index] * decayedSum_ - historyFactor_[index] *
+                    history_.history()[history_.getRelative(windowSamples_[index])];
+        }
+
+    public:
+        LazyTrueFloatingPointWeightedMovingAverageSet(
+                size_t maxWindowSamples, size_t errorMitigatingTimeConstant, size_t maxTimeConstants, S average);
+
+        size_t getMaxWindows() const { return entries_; }
+        size_t getUsedWindows() const { return usedWindows_; }
+        size_t getMaxWindowSamples() const { return history_.historySize(); }
+
+        /**
+         * Returns the smallest window size whose average has SNR_BITS of
+         * precision, given the error mitigating decay.
+         */
+        size_t getMinimumWindowSamples() const { return minimumWindowSamples_; }
+
+        void setUsedWindows(size_t windows);
+
+        void setWindowSizeAndScale(size_t index, size_t windowSamples, S scale);
+
+        void setAverages(S average);
+
+        /**
+         * Calculates and returns the scaled average of the window with the
+         * given index.
+         */
+        S getAverage(size_t index) const;
+
+        size_t getWindowSize(size_t index) const;
+
+        S getWindowScale(size_t index) const;
 
-        ~TrueFloatingPointWeightedMovingAverageSet();
+        void addInput(S input);
+
+        void addInputs(const S *input, size_t samples);
+
+        /**
+         * Calculates and returns the maximum of minimumValue and the scaled
+         * averages of all used windows.
+         */
+        S getMaximum(S minimumValue) const;
+    };
+
+    /**
+     * Implements a set of weighted moving averages like
+     * TrueFloatingPointWeightedMovingAverageSet, where long windows run at a
+     * lower rate, as their averages change slowly. Short windows are
+     * updated for each sample. Long windows are updated once every
+     * DECIMATION samples with the mean of those samples, so they cost
+     * 1/DECIMATION per sample. Their window sizes and error mitigating decay
+     * are in blocks of DECIMATION samples, and the signal-noise ratio is the
+     * one that SNR_BITS promises for those sizes in blocks.
+     *
+     * The maximum of the long windows is interpolated linearly between
+     * block updates, which delays it by one block. Long window sizes are
+     * rounded to whole blocks.
+     *
+     * @tparam S the type of samples used, normally "double"
+     * @tparam DECIMATION the number of samples per update of long windows
+     */
+    template<typename S, size_t DECIMATION, size_t SNR_BITS = 20, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO=10>
+    class MultiRateMovingAverageSet
+    {
+        static_assert(DECIMATION >= 2, "Decimation must be at least two");
+
+        using Set = TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>;
+
+        Set fullRate_;
+        Set decimated_;
+        S blockSum_ = 0;
+        size_t blockSamples_ = 0;
+        S longMaximum_ = 0;
+        S longStep_ = 0;
+        S longTarget_ = 0;
+
+        S getDecimatedMaximum() const;
+
+    public:
+        /**
+         * Creates a set with shortWindows windows of at most
+         * maxShortWindowSamples that run at full rate and longWindows windows
+         * of at most maxLongWindowSamples that run decimated. Both use the
+         * error mitigating decay, that for long windows is converted to
+         * blocks and must be valid in blocks.
+         */
+        MultiRateMovingAverageSet(
+                size_t maxShortWindowSamples, size_t maxLongWindowSamples,
+                size_t errorMitigatingTimeConstant,
+                size_t shortWindows, size_t longWindows, S average);
+
+        size_t getShortWindows() const { return fullRate_.getMaxWindows(); }
+
+        size_t getLongWindows() const { return decimated_.getMaxWindows(); }
+
+        /**
+         * Returns the total number of windows: indices of short windows come
+         * before those of long windows.
+         */
+        size_t getWindows() const { return getShortWindows() + getLongWindows(); }
+
+        void setWindowSizeAndScale(size_t index, size_t windowSamples, S scale);
+
+        size_t getWindowSize(size_t index) const;
+
+        S getWindowScale(size_t index) const;
+
+        void setAverages(S average);
+
+        /**
+         * Returns the scaled average of the window with the given index. For
+         * long windows, this is the average at the last block update.
+         */
+        S getAverage(size_t index) const;
+
+        S addInputGetMax(S input, S minimumValue);
+    };
+
+    /**
+     * Implements the same weighted moving average as
+     * TrueFloatingPointWeightedMovingAverage, but with a maximum window size
+     * that is known at compile time. The history is stored inline, so this
+     * average needs no heap allocation and can be part of a pre-allocated
+     * processing structure. If the capacity is rounded up to a power of two,
+     * history pointers wrap around with a mask.
+     *
+     * @tparam S the type of samples used, normally "double"
+     * @tparam MAX_SAMPLES the maximum window size in samples
+     * @tparam POWER2_CAPACITY whether to round history capacity up to a power of two
+     */
+    template<typename S, size_t MAX_SAMPLES, size_t SNR_BITS = 20, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO=10, bool POWER2_CAPACITY = true>
+    class FixedCapacityTrueFloatingPointWeightedMovingAverage
+    {
+    public:
+        using Metrics =
+                helper::HelperForMovingAverageMetricsForInaccurateTypes<
+                        S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>;
+
+    private:
+        static_assert(
+                is_between(MAX_SAMPLES, Metrics::MIN_MAX_WINDOW_SAMPLES, Metrics::MAX_MAX_WINDOW_SAMPLES),
+                "Maximum window size must lie between Metrics::MIN_MAX_WINDOW_SAMPLES and Metrics::MAX_MAX_WINDOW_SAMPLES");
+
+        using History = helper::FixedHistoryForTrueFloatingPointMovingAverage<
+                S, MAX_SAMPLES, POWER2_CAPACITY>;
+
+        History history_;
+        const size_t emdSamples_;
+        const S emdFactor_;
+        size_t windowSamples_ = 1;
+        S inputFactor_ = 1;
+        S historyFactor_ = 1;
+        size_t readPtr_ = 0;
+        S average_ = 0;
+
+        static size_t validEmdSamples(size_t emdSamples);
+
+    public:
+        static constexpr size_t CAPACITY = History::CAPACITY;
+
+        explicit FixedCapacityTrueFloatingPointWeightedMovingAverage(
+                const size_t emdSamples);
+
+        void setAverage(const S average);
+
+        void setWindowSize(const size_t windowSamples);
+
+        size_t getWindowSize() const { return windowSamples_; }
+
+        void addInput(const S input);
+
+        /**
+         * Adds a block of inputs and writes the average after each input to
+         * output, which may be the same as input. Results are identical to
+         * calling addInput() for each sample.
+         */
+        void addInputs(const S *input, S *output, size_t samples);
+
+        const S getAverage() const { return average_; }
+    };
+
+    /**
+     * Implements the same weighted moving average as
+     * TrueFloatingPointWeightedMovingAverage for CHANNELS channels at once.
+     * All channels share one window size and one set of coefficients and the
+     * history is a single ring of interleaved frames. This way, all channels
+     * are updated in a single loop that maps channels to vector lanes.
+     *
+     * @tparam S the type of samples used, normally "double"
+     * @tparam CHANNELS the number of channels
+     */
+    template<typename S, size_t CHANNELS, size_t SNR_BITS = 20, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO=10>
+    class MultiChannelMovingAverage
+    {
+        static_assert(CHANNELS > 0, "Number of channels must be positive");
+        static constexpr size_t ALIGN = 64;
+
+        const size_t historyFrames_;
+        Buffer<S> history_;
+        const size_t emdSamples_;
+        const S emdFactor_;
+        size_t historyEndPtr_;
+        size_t writePtr_ = 0;
+        size_t readPtr_ = 0;
+        size_t windowSamples_ = 1;
+        S inputFactor_ = 1;
+        S historyFactor_ = 1;
+        alignas(ALIGN) S average_[CHANNELS];
+
+        static size_t validHistoryFrames(size_t frames, size_t emdSamples);
+
+        void addFramesUnwrapped(const S *input, S *output, size_t frames);
+
+    public:
+        using Metrics =
+                helper::HelperForMovingAverageMetricsForInaccurateTypes<
+                        S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>;
+
+        MultiChannelMovingAverage(
+                const size_t maxWindowSize,
+                const size_t emdSamples);
+
+        static constexpr size_t getChannels() { return CHANNELS; }
+
+        size_t getMaxWindowSamples() const { return historyFrames_; }
+
+        size_t getWindowSize() const { return windowSamples_; }
+
+        void setAverage(const S average);
+
+        void setWindowSize(const size_t windowSamples);
+
+        /**
+         * Adds frames of CHANNELS interleaved inputs and writes the interleaved
+         * averages after each frame to output, which may be the same as input.
+         */
+        void addFrames(const S *input, S *output, size_t frames);
+
+        S getAverage(size_t channel) const
+        {
+            return average_[IndexPolicy::method(channel, CHANNELS)];
+        }
+
+        const S *getAverages() const { return average_; }
+    };
+
+    /**
+     * Implements an unweighted moving average for CHANNELS channels, with a
+     * running sum per channel that is compensated for rounding errors. The
+     * sum and its compensation together have about twice the precision of S,
+     * so that float storage and float vector lanes reach the window sizes
+     * and signal-noise ratio that SNR_BITS promises for double. As rounding
+     * errors do not accumulate, no error mitigating decay is needed and the
+     * average is the exact average of the window, rounded to S.
+     *
+     * Like MultiChannelMovingAverage, the history is a single ring of
+     * interleaved frames and channels map to vector lanes.
+     *
+     * @tparam S the type of samples used, normally "float"
+     * @tparam CHANNELS the number of channels
+     * @tparam SNR_BITS the minimum signal-noise ratio of the running sum in bits
+     */
+    template<typename S, size_t CHANNELS, size_t SNR_BITS = 20>
+    class CompensatedMultiChannelMovingAverage
+    {
+        static_assert(std::is_floating_point<S>::value, "Sample type must be floating point");
+        static_assert(CHANNELS > 0, "Number of channels must be positive");
+        static constexpr size_t ALIGN = 64;
+
+    public:
+        /**
+         * The compensated sum has an epsilon of about the square of that of S.
+         */
+        static constexpr size_t MAX_WINDOW_SAMPLES = minimum(
+                1.0 / ((static_cast<size_t>(1) << SNR_BITS) *
+                       std::numeric_limits<S>::epsilon() *
+                       std::numeric_limits<S>::epsilon()),
+                std::numeric_limits<size_t>::max() / 2 / CHANNELS);
+
+    private:
+        const size_t historyFrames_;
+        Buffer<S> history_;
+        size_t writePtr_ = 0;
+        size_t readPtr_ = 0;
+        size_t windowSamples_ = 1;
+        S windowScale_ = 1;
+        alignas(ALIGN) S sum_[CHANNELS];
+        alignas(ALIGN) S compensation_[CHANNELS];
+
+        void addFramesUnwrapped(const S *input, S *output, size_t frames);
+
+    public:
+        explicit CompensatedMultiChannelMovingAverage(const size_t maxWindowSize);
+
+        static constexpr size_t getChannels() { return CHANNELS; }
+
+        size_t getMaxWindowSamples() const { return historyFrames_; }
+
+        size_t getWindowSize() const { return windowSamples_; }
+
+        void setAverage(const S average);
+
+        /**
+         * Sets the window size and re-synchronises the running sums with the
+         * history, so that the average immediately is that of the new window.
+         */
+        void setWindowSize(const size_t windowSamples);
+
+        /**
+         * Recalculates the running sums from the history. As the compensated
+         * sums do not drift significantly, this is not necessary in normal
+         * use, but it can be called periodically from a non-critical context
+         * to remove any residual error.
+         */
+        void resynchronise();
+
+        /**
+         * Adds frames of CHANNELS interleaved inputs and writes the interleaved
+         * averages after each frame to output, which may be the same as input.
+         */
+        void addFrames(const S *input, S *output, size_t frames);
+
+        S getAverage(size_t channel) const
+        {
+            const size_t i = IndexPolicy::method(channel, CHANNELS);
+            return (sum_[i] + compensation_[i]) * windowScale_;
+        }
+    };
+
+    /**
+     * Implements an exact moving average for integral samples, like (24-bit)
+     * PCM. The window keeps the sum of its samples in an accumulator that is
+     * wide enough to never overflow, so adding a new sample and subtracting
+     * the oldest one has no precision loss and no error mitigating decay is
+     * needed.
+     *
+     * @tparam S the type of samples used, normally int32_t
+     * @tparam A the type of the sum of samples, normally int64_t
+     */
+    template<typename S = int32_t, typename A = int64_t>
+    class PreciseWindowAverage
+    {
+        static_assert(std::is_integral<S>::value && std::is_integral<A>::value,
+                      "Sample and accumulator types must be integral");
+        static_assert(sizeof(A) > sizeof(S), "Accumulator type must be wider than sample type");
+
+    public:
+        /**
+         * The biggest window whose sum cannot overflow the accumulator.
+         */
+        static constexpr size_t MAX_WINDOW_SAMPLES = minimum(
+                std::numeric_limits<A>::max() / (static_cast<A>(std::numeric_limits<S>::max()) + 1),
+                std::numeric_limits<size_t>::max() / 2);
+
+    private:
+        const size_t historySamples_;
+        Buffer<S> history_;
+        size_t writePtr_ = 0;
+        size_t readPtr_ = 0;
+        size_t windowSamples_ = 1;
+        double windowScale_ = 1;
+        A sum_ = 0;
+
+    public:
+        explicit PreciseWindowAverage(const size_t maxWindowSize);
+
+        size_t getMaxWindowSamples() const { return historySamples_; }
+
+        size_t getWindowSize() const { return windowSamples_; }
+
+        void setAverage(const S average);
+
+        /**
+         * Sets the window size and recalculates the sum from the history, so
+         * that the average immediately is that of the new window.
+         */
+        void setWindowSize(const size_t windowSamples);
+
+        void addInput(const S input)
+        {
+            sum_ += static_cast<A>(input) - history_[readPtr_];
+            history_[writePtr_] = input;
+            readPtr_ = readPtr_ > 0 ? readPtr_ - 1 : historySamples_ - 1;
+            writePtr_ = writePtr_ > 0 ? writePtr_ - 1 : historySamples_ - 1;
+        }
+
+        /**
+         * Returns the exact sum of all samples in the window.
+         */
+        A getSum() const { return sum_; }
+
+        double getAverage() const { return windowScale_ * sum_; }
+    };
+
+    /**
+     * Implements a set of exact moving averages for integral samples, that
+     * share the same history, with the same API as
+     * TrueFloatingPointWeightedMovingAverageSet. The sums of all windows
+     * are stored as structure of arrays. Each window keeps its distance to
+     * the write pointer as a 32-bit offset, instead of its own read
+     * pointer. The history is stored twice in a row, so that the write
+     * pointer plus an offset never needs to wrap. That way, updating the
+     * sums and taking the maximum of the averages is a single loop that
+     * vectorizes, with an emulated gather of the history samples.
+     *
+     * @tparam S the type of samples used, normally int32_t
+     * @tparam A the type of the sum of samples, normally int64_t
+     */
+    template<typename S = int32_t, typename A = int64_t>
+    class PreciseWindowAverageSet
+    {
+        static constexpr size_t MINIMUM_TIME_CONSTANTS = 1;
+        static constexpr size_t MAXIMUM_TIME_CONSTANTS = 32;
+        static constexpr size_t ALIGN = 64;
+        static constexpr size_t LANES = ALIGN / sizeof(double);
+        using Offset = uint32_t;
+        static constexpr const char * TIME_CONSTANT_MESSAGE =
+                "The (maximum) number of time-constants must lie between "
+        TDAP_QUOTE(MINIMUM_TIME_CONSTANTS) " and "
+        TDAP_QUOTE(MAXIMUM_TIME_CONSTANTS) ".";
+
+    public:
+        /**
+         * The biggest window whose sum cannot overflow the accumulator,
+         * whose size fits an offset and whose sum has a magnitude below
+         * 2^51, so that it can be converted to double without a cast.
+         */
+        static constexpr size_t MAX_WINDOW_SAMPLES = minimum(
+                minimum(PreciseWindowAverage<S, A>::MAX_WINDOW_SAMPLES,
+                        static_cast<size_t>(std::numeric_limits<Offset>::max())),
+                (static_cast<size_t>(1) << 51) / (static_cast<size_t>(std::numeric_limits<S>::max()) + 1));
+
+    private:
+        const size_t entries_;
+        size_t usedWindows_;
+        const size_t historySamples_;
+        Buffer<S> history_;
+        size_t writePtr_ = 0;
+        alignas(ALIGN) A sum_[MAXIMUM_TIME_CONSTANTS];
+        alignas(ALIGN) Offset readOffset_[MAXIMUM_TIME_CONSTANTS];
+        alignas(ALIGN) double factor_[MAXIMUM_TIME_CONSTANTS];
+        size_t windowSamples_[MAXIMUM_TIME_CONSTANTS];
+        double scale_[MAXIMUM_TIME_CONSTANTS];
+
+        static size_t validMaxTimeConstants(size_t constants);
+
+        size_t checkWindowIndex(size_t index) const;
+
+        /**
+         * Converts a sum to double like a cast. A 64-bit integer to double
+         * conversion is not vectorized without AVX-512, so those sums are
+         * converted with integer and floating point arithmetic instead.
+         */
+        static inline double toDouble(A sum);
+
+        void write(S input);
+
+        void synchronise(size_t index);
+
+    public:
+        PreciseWindowAverageSet(
+                size_t maxWindowSamples, size_t maxTimeConstants, S average);
+
+        size_t getMaxWindows() const { return entries_; }
+        size_t getUsedWindows() const { return usedWindows_; }
+        size_t getMaxWindowSamples() const { return historySamples_; }
+
+        void setUsedWindows(size_t windows);
+
+        /**
+         * Sets the window size and scale of the window with the given index
+         * and recalculates its sum from the history.
+         */
+        void setWindowSizeAndScale(size_t index, size_t windowSamples, double scale);
+
+        void setAverages(S average);
+
+        double getAverage(size_t index) const;
+
+        /**
+         * Returns the exact sum of all samples in the window with the given
+         * index.
+         */
+        A getSum(size_t index) const;
+
+        size_t getWindowSize(size_t index) const;
+
+        double getWindowScale(size_t index) const;
+
+        void addInput(S input) TDAP_RESTRICT_THIS;
+
+        /**
+         * Adds the input and returns the maximum of minimumValue and all
+         * scaled averages of used windows.
+         */
+        double addInputGetMax(S input, double minimumValue) TDAP_RESTRICT_THIS;
+    };
+
+    /**
+     * Implements a true rectangular moving average with a plain running sum,
+     * without error mitigating decay. To bound the drift of the running sum
+     * that rounding errors cause, a shadow sum adds only new samples. Each
+     * time that the shadow sum has added a complete window of samples, it
+     * is the exact sum of the window, rounded only window-size times, and
+     * it replaces the running sum. This costs one addition per sample, but
+     * saves a multiplication, compared to the decaying average.
+     *
+     * @tparam S the type of samples used, normally "double"
+     * @tparam SNR_BITS the minimum signal-noise ratio of the average in bits
+     */
+    template<typename S = double, size_t SNR_BITS = 20>
+    class ResynchronisingMovingAverage
+    {
+        static_assert(std::is_floating_point<S>::value, "Sample type must be floating point");
+
+    public:
+        /**
+         * Rounding errors of the sum of a window grow with the window size.
+         */
+        static constexpr size_t MAX_WINDOW_SAMPLES = minimum(
+                1.0 / ((static_cast<size_t>(1) << SNR_BITS) *
+                       std::numeric_limits<S>::epsilon()),
+                std::numeric_limits<size_t>::max() / 2);
+
+    private:
+        const size_t historySamples_;
+        Buffer<S> history_;
+        size_t writePtr_ = 0;
+        size_t readPtr_ = 0;
+        size_t windowSamples_ = 1;
+        S windowScale_ = 1;
+        S sum_ = 0;
+        S shadowSum_ = 0;
+        size_t shadowSamples_ = 0;
+
+        inline void resynchroniseIfComplete();
+
+    public:
+        explicit ResynchronisingMovingAverage(const size_t maxWindowSize);
+
+        size_t getMaxWindowSamples() const { return historySamples_; }
+
+        size_t getWindowSize() const { return windowSamples_; }
+
+        void setAverage(const S average);
+
+        /**
+         * Sets the window size and recalculates the sum from the history, so
+         * that the average immediately is that of the new window.
+         */
+        void setWindowSize(const size_t windowSamples);
+
+        void addInput(const S input);
+
+        /**
+         * Adds a block of inputs and writes the average after each input to
+         * output, which may be the same as input. Results are identical to
+         * calling addInput() for each sample.
+         */
+        void addInputs(const S *input, S *output, size_t samples);
+
+        S getAverage() const { return windowScale_ * sum_; }
+    };
+
+    /**
+     * Keeps a history of samples with the sums of all aligned blocks of two,
+     * four, eight and more samples, so that the sum or average of the most
+     * recent samples can be queried for any window size up to the maximum in
+     * O(log(window size)). Adding a sample completes on average one block,
+     * so updates cost O(1), regardless of the number of windows that are
+     * queried. Block sums are calculated from scratch, so for floating point
+     * samples, errors do not accumulate and there is no error mitigating
+     * decay. For integral samples, sums are exact.
+     *
+     * @tparam S the type of samples used, normally "double"
+     */
+    template<typename S = double>
+    class WindowSumTree
+    {
+        static_assert(std::is_arithmetic<S>::value, "Sample type must be arithmetic");
+        static constexpr size_t MAX_LEVELS = 8 * sizeof(size_t);
+
+        const size_t historySamples_;
+        const size_t levels_;
+        size_t offset_[MAX_LEVELS];
+        size_t mask_[MAX_LEVELS];
+        Buffer<S> blocks_;
+        // Index of the next sample, counted from the start of the history
+        size_t next_ = 0;
+
+        static size_t validHistorySamples(size_t samples);
+        static size_t levelsFor(size_t samples);
+        size_t totalBlocks();
+
+        S &block(size_t level, size_t index)
+        {
+            return blocks_[offset_[level] + (index & mask_[level])];
+        }
+
+        const S &block(size_t level, size_t index) const
+        {
+            return blocks_[offset_[level] + (index & mask_[level])];
+        }
+
+    public:
+        explicit WindowSumTree(const size_t maxWindowSize);
+
+        size_t getMaxWindowSamples() const { return historySamples_; }
+
+        /**
+         * Fills the complete history with average.
+         */
+        void setAverage(const S average);
+
+        void addInput(const S input);
+
+        void addInputs(const S *input, size_t samples);
+
+        /**
+         * Returns the sum of the most recent windowSamples samples.
+         */
+        S getSum(size_t windowSamples) const;
+
+        /**
+         * Returns the average of the most recent windowSamples samples.
+         */
+        S getAverage(size_t windowSamples) const
+        {
+            return getSum(windowSamples) / static_cast<S>(windowSamples);
+        }
     };
 
 }
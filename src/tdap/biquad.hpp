@@ -0,0 +1,111 @@
+#ifndef TDAP_BIQUAD_HPP
+#define TDAP_BIQUAD_HPP
+/*
+ * tdap/biquad.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <type_traits>
+
+namespace tdap::filter
+{
+    /**
+     * Second order IIR filter in transposed direct form II. The filter method
+     * is not virtual, so that biquads can be inlined in a FilterChain. Use a
+     * FilterAdapter to use a biquad as a Filter.
+     */
+    template<typename T>
+    class Biquad
+    {
+        static_assert(std::is_floating_point<T>::value);
+
+        T b0_ = 1;
+        T b1_ = 0;
+        T b2_ = 0;
+        T a1_ = 0;
+        T a2_ = 0;
+        T z1_ = 0;
+        T z2_ = 0;
+
+    public:
+        Biquad() = default;
+
+        Biquad(T b0, T b1, T b2, T a1, T a2)
+        {
+            setCoefficients(b0, b1, b2, a1, a2);
+        }
+
+        /**
+         * Sets the coefficients, normalised for a0 = 1, where the feedback
+         * coefficients a1 and a2 are subtracted.
+         */
+        void setCoefficients(T b0, T b1, T b2, T a1, T a2);
+
+        T filter(const T input)
+        {
+            const T output = b0_ * input + z1_;
+            z1_ = b1_ * input - a1_ * output + z2_;
+            z2_ = b2_ * input - a2_ * output;
+            return output;
+        }
+
+        /**
+         * Filters a block of samples, keeping the state in local variables.
+         * Input and output may be the same.
+         */
+        void filter(const T *input, T *output, size_t samples);
+
+        void reset()
+        {
+            z1_ = 0;
+            z2_ = 0;
+        }
+
+        /**
+         * Returns the biggest radius of the two poles in the z-plane.
+         */
+        double getMaximumPoleRadius() const;
+
+        /**
+         * Returns a second order low pass filter, using the well-known
+         * formulas of Robert Bristow-Johnson.
+         */
+        static Biquad lowPass(double sampleRate, double frequency, double q);
+
+        /**
+         * Returns a second order high pass filter, using the well-known
+         * formulas of Robert Bristow-Johnson.
+         */
+        static Biquad highPass(double sampleRate, double frequency, double q);
+
+        /**
+         * Returns a peaking filter with gain in decibels, using the well-known
+         * formulas of Robert Bristow-Johnson.
+         */
+        static Biquad peaking(double sampleRate, double frequency, double q, double gain);
+    };
+
+}
+
+#ifndef TDAP_INCLUDE_NO_IMPLEMENTATION
+#include <tdap/impl/biquad-impl.hpp>
+#endif
+
+#endif //TDAP_BIQUAD_HPP
@@ -0,0 +1,190 @@
+#ifndef TDAP_BUCKET_AVERAGE_HPP
+#define TDAP_BUCKET_AVERAGE_HPP
+/*
+ * tdap/bucket-average.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <tdap/boundaries.hpp>
+
+namespace tdap::average
+{
+    /**
+     * Approximates a rectangular moving average over a window that consists
+     * of a number of buckets with the sum of bucket-size samples each. The
+     * most recent samples fill a partial bucket and the part that is not
+     * filled yet counts as samples with the average at the time the previous
+     * bucket was completed. This needs no per-sample history, so the window
+     * can be long and cheap.
+     *
+     * When a bucket is complete, it replaces the oldest bucket in a running
+     * sum of complete buckets, so the cost per sample is flat. To bound the
+     * drift of that running sum, a shadow sum adds only completed buckets and
+     * replaces the running sum each time it is the exact sum of all complete
+     * buckets.
+     *
+     * @tparam S the type of samples used, normally "double"
+     * @tparam MAX_BUCKETS the maximum number of buckets
+     */
+    template<typename S, size_t MAX_BUCKETS>
+    class BucketAverage
+    {
+        static_assert(std::is_floating_point<S>::value, "Sample type must be floating point");
+
+    public:
+        static constexpr size_t MAX_MAX_BUCKETS = 64;
+        static constexpr size_t MIN_BUCKETS = 2;
+        static_assert(boundaries::is_between(MAX_BUCKETS, MIN_BUCKETS, MAX_MAX_BUCKETS),
+                      "Number of buckets must be between 2 and 64");
+
+    private:
+        S bucket_[MAX_BUCKETS];
+        size_t bucketSize_ = 1;
+        size_t bucketCount_ = MAX_BUCKETS;
+        // The bucket that is being filled, that replaces the oldest bucket
+        size_t current_ = 0;
+        // Samples that the current bucket still needs to be complete
+        size_t remaining_ = 1;
+        S partialSum_ = 0;
+        // Sum of all complete buckets, except the oldest one
+        S completeSum_ = 0;
+        S shadowSum_ = 0;
+        size_t shadowBuckets_ = 0;
+        // The value of samples that the current bucket still needs
+        S fill_ = 0;
+        // Sum of the window: complete buckets, except the oldest one, the
+        // partial sum and the remaining samples times the fill value.
+        S sum_ = 0;
+        S userScale_ = 1;
+        S scale_ = 1.0 / MAX_BUCKETS;
+        S average_ = 0;
+
+        inline void completeBucket();
+
+    public:
+        BucketAverage();
+
+        size_t getWindowSize() const { return bucketCount_ * bucketSize_; }
+
+        size_t getBucketCount() const { return bucketCount_; }
+
+        size_t getBucketSize() const { return bucketSize_; }
+
+        /**
+         * Sets the bucket size and count so that the window size approximates
+         * the given number of samples. The biggest bucket count, that is
+         * not smaller than the minimum preferred bucket count, that yields a
+         * relative window size error smaller than the maximum is preferred,
+         * then the biggest smaller bucket count that does, and otherwise
+         * the bucket count with the smallest error.
+         *
+         * @return the actual window size
+         */
+        size_t setApproximateWindowSize(
+                size_t windowSamples,
+                double maxRelativeError = 0.01,
+                size_t minimumPreferredBucketCount = MIN_BUCKETS);
+
+        void setBucketCount(size_t count) { setBucketSizeAndCount(bucketSize_, count); }
+
+        void setBucketSize(size_t size) { setBucketSizeAndCount(size, bucketCount_); }
+
+        /**
+         * Sets the bucket size and count and fills all buckets with the
+         * current average.
+         */
+        void setBucketSizeAndCount(size_t size, size_t count);
+
+        /**
+         * Sets the scale of the average that is returned.
+         */
+        void setOutputScale(S scale);
+
+        void setAverage(S average);
+
+        S addInputGetAverage(S input);
+
+        /**
+         * Adds a block of inputs and writes the average after each input to
+         * output, which may be the same as input. Results are identical to
+         * calling addInputGetAverage() for each sample.
+         */
+        void addInputs(const S *input, S *output, size_t samples);
+
+        S getAverage() const { return average_; }
+    };
+
+    /**
+     * Approximates a root-mean-square over a window, using a BucketAverage
+     * of squared samples.
+     *
+     * @tparam S the type of samples used, normally "double"
+     * @tparam MAX_BUCKETS the maximum number of buckets
+     */
+    template<typename S, size_t MAX_BUCKETS>
+    class BucketRms
+    {
+        using Average = BucketAverage<S, MAX_BUCKETS>;
+        Average average_;
+
+    public:
+        const Average &average() const { return average_; }
+
+        size_t setApproximateWindowSize(
+                size_t windowSamples,
+                double maxRelativeError = 0.01,
+                size_t minimumPreferredBucketCount = Average::MIN_BUCKETS)
+        {
+            return average_.setApproximateWindowSize(
+                    windowSamples, maxRelativeError, minimumPreferredBucketCount);
+        }
+
+        void setBucketCount(size_t count) { average_.setBucketCount(count); }
+
+        void setBucketSize(size_t size) { average_.setBucketSize(size); }
+
+        void setBucketSizeAndCount(size_t size, size_t count)
+        {
+            average_.setBucketSizeAndCount(size, count);
+        }
+
+        void setRms(S rms) { average_.setAverage(rms * rms); }
+
+        void setOutputScale(S scale) { average_.setOutputScale(scale * scale); }
+
+        S addInputGetRms(S input);
+
+        /**
+         * Adds a block of inputs and writes the RMS after each input to
+         * output, which may be the same as input.
+         */
+        void addInputs(const S *input, S *output, size_t samples);
+
+        S getRms() const;
+    };
+
+}
+
+#ifndef TDAP_INCLUDE_NO_IMPLEMENTATION
+#include <tdap/impl/bucket-average-impl.hpp>
+#endif
+
+#endif //TDAP_BUCKET_AVERAGE_HPP
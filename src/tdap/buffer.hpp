@@ -0,0 +1,189 @@
+#ifndef TDAP_BUFFER_HPP
+#define TDAP_BUFFER_HPP
+/*
+ * tdap/buffer.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <tdap/macros.hpp>
+
+namespace tdap
+{
+    /**
+     * Alignment in bytes of the storage of arrays and buffers: a cache line,
+     * that is also a multiple of the width of all vector instruction sets.
+     */
+    inline constexpr size_t BUFFER_ALIGNMENT = 64;
+
+    /**
+     * Returns the number of elements of type T, rounded up to a multiple of
+     * BUFFER_ALIGNMENT bytes.
+     */
+    template<typename T>
+    constexpr size_t paddedElements(size_t elements)
+    {
+        constexpr size_t perAlignment =
+                sizeof(T) < BUFFER_ALIGNMENT ? BUFFER_ALIGNMENT / sizeof(T) : 1;
+        return (elements + perAlignment - 1) / perAlignment * perAlignment;
+    }
+
+    /**
+     * Adds element access, fill, zero, copy and move to an array with
+     * consecutive storage that is aligned to BUFFER_ALIGNMENT bytes and
+     * padded to a multiple of that. Fill, zero and copying a whole array run
+     * over the padded elements, so that their loops need no remainder and
+     * are vectorised without alignment checks. Element access is not range
+     * checked, as it is used in processing loops.
+     *
+     * @tparam T the type of elements, that must be trivially copyable
+     * @tparam ARRAY the implementation, that provides data(), size() and
+     * paddedSize()
+     */
+    template<typename T, class ARRAY>
+    class ArrayTraits
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Element type must be trivially copyable");
+
+        ARRAY &self() { return *static_cast<ARRAY *>(this); }
+
+        const ARRAY &self() const { return *static_cast<const ARRAY *>(this); }
+
+        T *alignedData() { return TDAP_ASSUME_ALIGNED(self().data(), BUFFER_ALIGNMENT); }
+
+        const T *alignedData() const { return TDAP_ASSUME_ALIGNED(self().data(), BUFFER_ALIGNMENT); }
+
+    public:
+        T &operator[](size_t i) { return self().data()[i]; }
+
+        const T &operator[](size_t i) const { return self().data()[i]; }
+
+        T *begin() { return self().data(); }
+
+        T *end() { return self().data() + self().size(); }
+
+        const T *begin() const { return self().data(); }
+
+        const T *end() const { return self().data() + self().size(); }
+
+        /**
+         * Sets all elements, including the padding, to value.
+         */
+        void fill(const T &value);
+
+        /**
+         * Sets all elements, including the padding, to zero.
+         */
+        void zero();
+
+        /**
+         * Copies all elements of source, that must have the same size.
+         */
+        template<class SOURCE>
+        void copy(const ArrayTraits<T, SOURCE> &source);
+
+        /**
+         * Copies length elements of source, starting at sourceOffset, to
+         * this array, starting at offset.
+         */
+        template<class SOURCE>
+        void copy(size_t offset, const ArrayTraits<T, SOURCE> &source,
+                  size_t sourceOffset, size_t length);
+
+        /**
+         * Moves length elements within this array from source to
+         * destination, where both ranges may overlap.
+         */
+        void move(size_t destination, size_t source, size_t length);
+    };
+
+    /**
+     * An array with a size that is known at compile time, stored inline.
+     */
+    template<typename T, size_t SIZE>
+    class Array : public ArrayTraits<T, Array<T, SIZE>>
+    {
+        static_assert(SIZE > 0, "Array size must be positive");
+        static constexpr size_t PADDED_SIZE = paddedElements<T>(SIZE);
+
+        alignas(BUFFER_ALIGNMENT) T data_[PADDED_SIZE] {};
+
+    public:
+        Array() = default;
+
+        explicit Array(const T &value) { this->fill(value); }
+
+        static constexpr size_t size() { return SIZE; }
+
+        static constexpr size_t paddedSize() { return PADDED_SIZE; }
+
+        T *data() { return data_; }
+
+        const T *data() const { return data_; }
+    };
+
+    /**
+     * A buffer with a size that is set at construction, stored on the heap.
+     * All elements, including the padding, start as zero.
+     */
+    template<typename T>
+    class Buffer : public ArrayTraits<T, Buffer<T>>
+    {
+        size_t size_;
+        size_t paddedSize_;
+        T *data_;
+
+        static size_t validSize(size_t size);
+
+        static T *allocate(size_t paddedSize);
+
+        static void free(T *data);
+
+    public:
+        explicit Buffer(size_t size);
+
+        Buffer(size_t size, const T &value);
+
+        Buffer(const Buffer &source);
+
+        Buffer(Buffer &&source) noexcept;
+
+        Buffer &operator=(const Buffer &) = delete;
+
+        Buffer &operator=(Buffer &&) = delete;
+
+        size_t size() const { return size_; }
+
+        size_t paddedSize() const { return paddedSize_; }
+
+        T *data() { return data_; }
+
+        const T *data() const { return data_; }
+
+        ~Buffer();
+    };
+
+}
+
+#ifndef TDAP_INCLUDE_NO_IMPLEMENTATION
+#include <tdap/impl/buffer-impl.hpp>
+#endif
+
+#endif //TDAP_BUFFER_HPP
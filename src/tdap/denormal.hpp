@@ -0,0 +1,89 @@
+#ifndef TDAP_DENORMAL_HPP
+#define TDAP_DENORMAL_HPP
+/*
+ * tdap/denormal.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Decaying recursive filters produce denormal numbers, which are very slow to
+ * calculate with on most processors. While a ZeroDenormals instance lives, the
+ * current thread flushes denormal results to zero and treats denormal inputs
+ * as zero. On processors where this is not supported, it does nothing.
+ */
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define TDAP_DENORMAL_SSE 1
+#elif defined(__aarch64__)
+#include <cstdint>
+#define TDAP_DENORMAL_AARCH64 1
+#endif
+
+namespace tdap
+{
+    class ZeroDenormals
+    {
+#if TDAP_DENORMAL_SSE
+        // Flush-to-zero and denormals-are-zero
+        static constexpr unsigned FLAGS = 0x8040;
+        const unsigned state_;
+
+        static unsigned getState() { return _mm_getcsr(); }
+
+        static void setState(unsigned state) { _mm_setcsr(state); }
+#elif TDAP_DENORMAL_AARCH64
+        // Flush-to-zero
+        static constexpr uint64_t FLAGS = uint64_t(1) << 24;
+        const uint64_t state_;
+
+        static uint64_t getState()
+        {
+            uint64_t state;
+            asm volatile("mrs %0, fpcr" : "=r"(state));
+            return state;
+        }
+
+        static void setState(uint64_t state)
+        {
+            asm volatile("msr fpcr, %0" : : "r"(state));
+        }
+#endif
+
+    public:
+#if TDAP_DENORMAL_SSE || TDAP_DENORMAL_AARCH64
+        ZeroDenormals() : state_(getState())
+        {
+            setState(state_ | FLAGS);
+        }
+
+        ~ZeroDenormals()
+        {
+            setState(state_);
+        }
+#else
+        ZeroDenormals() = default;
+#endif
+
+        ZeroDenormals(const ZeroDenormals &) = delete;
+
+        ZeroDenormals &operator=(const ZeroDenormals &) = delete;
+    };
+
+}
+
+#endif //TDAP_DENORMAL_HPP
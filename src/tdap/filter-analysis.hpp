@@ -0,0 +1,84 @@
+#ifndef TDAP_FILTER_ANALYSIS_HPP
+#define TDAP_FILTER_ANALYSIS_HPP
+/*
+ * tdap/filter-analysis.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <tdap/filter.hpp>
+
+namespace tdap::filter
+{
+    /**
+     * Creates a clone of a filter, with its own state.
+     */
+    template<typename T>
+    using FilterClone = std::function<std::unique_ptr<Filter<T>>(const Filter<T> &)>;
+
+    /**
+     * Returns the effective impulse response lengths of a bank of filters,
+     * in the same order as the filters, as measured by
+     * Filter::getEffectiveImpulseResponseLengthFast(). The filters are
+     * analyzed in parallel on a number of threads, that each take the next
+     * filter that was not analyzed yet. Each analysis uses a clone of the
+     * filter and of the weighting, so the filters themselves are not
+     * changed. If an analysis throws, the first exception is rethrown after
+     * all threads finished. A filter that is null and a clone function that
+     * returns no filter throw std::invalid_argument.
+     *
+     * @param filters The filters to analyze.
+     * @param count The number of filters.
+     * @param clone Creates the clones of the filters and the weighting.
+     * @param maxLength Maximum length to measure until
+     * @param threshold The maximum relative energy that the window can have.
+     * @param windowSize The size of the window.
+     * @param threads The number of threads to use, where zero means the
+     *      number of hardware threads.
+     * @param weighting The weighting used, or nullptr for no weighting.
+     * @return The effective lengths, with -1 for each failed measurement.
+     */
+    template<typename T>
+    std::vector<ssize_t> getEffectiveImpulseResponseLengths(
+            const Filter<T> * const *filters, size_t count,
+            const FilterClone<T> &clone, size_t maxLength, double threshold,
+            size_t windowSize, size_t threads = 0,
+            const Filter<T> *weighting = nullptr);
+
+    template<typename T>
+    std::vector<ssize_t> getEffectiveImpulseResponseLengths(
+            const std::vector<const Filter<T> *> &filters,
+            const FilterClone<T> &clone, size_t maxLength, double threshold,
+            size_t windowSize, size_t threads = 0,
+            const Filter<T> *weighting = nullptr)
+    {
+        return getEffectiveImpulseResponseLengths(
+                filters.data(), filters.size(), clone, maxLength, threshold,
+                windowSize, threads, weighting);
+    }
+
+}
+
+#ifndef TDAP_INCLUDE_NO_IMPLEMENTATION
+#include <tdap/impl/filter-analysis-impl.hpp>
+#endif
+
+#endif //TDAP_FILTER_ANALYSIS_HPP
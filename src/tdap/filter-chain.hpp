@@ -0,0 +1,186 @@
+#ifndef TDAP_FILTER_CHAIN_HPP
+#define TDAP_FILTER_CHAIN_HPP
+/*
+ * tdap/filter-chain.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <tdap/filter.hpp>
+
+namespace tdap::filter
+{
+    namespace helper
+    {
+        template<class F, typename = void>
+        struct HasMaximumPoleRadius : public std::false_type {};
+
+        template<class F>
+        struct HasMaximumPoleRadius<F, std::void_t<decltype(
+                std::declval<const F &>().getMaximumPoleRadius())>> :
+                public std::true_type {};
+
+        template<class F, typename T, typename = void>
+        struct HasBlockFilter : public std::false_type {};
+
+        template<class F, typename T>
+        struct HasBlockFilter<F, T, std::void_t<decltype(
+                std::declval<F &>().filter(
+                        std::declval<const T *>(), std::declval<T *>(), std::declval<size_t>()))>> :
+                public std::true_type {};
+
+        /**
+         * Returns the maximum pole radius of the filter, or a negative value
+         * if the filter does not provide it.
+         */
+        template<class F>
+        inline double maximumPoleRadiusOf(const F &filter)
+        {
+            if constexpr (HasMaximumPoleRadius<F>::value) {
+                return filter.getMaximumPoleRadius();
+            }
+            else {
+                return -1;
+            }
+        }
+    }
+
+    /**
+     * A chain of filters with types that are known at compile time. Each
+     * filter type must have the methods "T filter(const T input)" and
+     * "void reset()", which is also what the chain itself provides, so chains
+     * can be nested. As no call is virtual, the whole chain can be inlined
+     * into the loop that uses it. Use a FilterAdapter to plug a chain in where
+     * a Filter is expected.
+     *
+     * @tparam T the type of samples used
+     * @tparam F the types of the filters, in the order they are applied
+     */
+    template<typename T, class... F>
+    class FilterChain
+    {
+        static_assert(sizeof...(F) > 0, "A filter chain needs at least one filter");
+
+        std::tuple<F...> filters_;
+
+        template<size_t... I>
+        T filter(const T input, std::index_sequence<I...>)
+        {
+            T value = input;
+            ((value = std::get<I>(filters_).filter(value)), ...);
+            return value;
+        }
+
+    public:
+        FilterChain() = default;
+
+        explicit FilterChain(const F &... filters) : filters_(filters...) {}
+
+        static constexpr size_t size() { return sizeof...(F); }
+
+        template<size_t I>
+        auto &get() { return std::get<I>(filters_); }
+
+        template<size_t I>
+        const auto &get() const { return std::get<I>(filters_); }
+
+        T filter(const T input)
+        {
+            return filter(input, std::index_sequence_for<F...>());
+        }
+
+        void filter(const T *input, T *output, size_t samples)
+        {
+            for (size_t i = 0; i < samples; i++) {
+                output[i] = filter(input[i]);
+            }
+        }
+
+        void reset()
+        {
+            std::apply([](F &... filters) { (filters.reset(), ...); }, filters_);
+        }
+
+        /**
+         * Returns the biggest pole radius of all filters, or a negative value
+         * if that is not known for one of the filters.
+         */
+        double getMaximumPoleRadius() const
+        {
+            return std::apply([](const F &... filters) {
+                double result = 0;
+                auto add = [&result](double radius) {
+                    result = result < 0 || radius < 0 ? -1 : std::max(result, radius);
+                };
+                (add(helper::maximumPoleRadiusOf(filters)), ...);
+                return result;
+            }, filters_);
+        }
+    };
+
+    /**
+     * Exposes a filter with non-virtual filter methods, like a Biquad or a
+     * FilterChain, as a Filter. The filter must have the methods
+     * "T filter(const T input)" and "void reset()". If it also has a block
+     * method "void filter(const T *input, T *output, size_t samples)", that
+     * is used to filter blocks; otherwise blocks are filtered per sample,
+     * still without virtual calls.
+     */
+    template<typename T, class F>
+    class FilterAdapter : public Filter<T>
+    {
+        F filter_;
+
+    public:
+        FilterAdapter() = default;
+
+        explicit FilterAdapter(const F &filter) : filter_(filter) {}
+
+        F &adapted() { return filter_; }
+
+        const F &adapted() const { return filter_; }
+
+        T filter(const T input) override { return filter_.filter(input); }
+
+        void filter(const T *input, T *output, size_t samples) override
+        {
+            if constexpr (helper::HasBlockFilter<F, T>::value) {
+                filter_.filter(input, output, samples);
+            }
+            else {
+                for (size_t i = 0; i < samples; i++) {
+                    output[i] = filter_.filter(input[i]);
+                }
+            }
+        }
+
+        void reset() override { filter_.reset(); }
+
+        double getMaximumPoleRadius() const override
+        {
+            return helper::maximumPoleRadiusOf(filter_);
+        }
+    };
+
+}
+
+#endif //TDAP_FILTER_CHAIN_HPP
@@ -32,8 +32,26 @@ namespace tdap::filter
 
         virtual T filter(const T input) { return input; }
 
+        /**
+         * Filters a block of samples from input to output, which may be the
+         * same. The default calls filter(input) for each sample, but
+         * implementations can override this with a loop without virtual calls.
+         */
+        virtual void filter(const T *input, T *output, size_t samples)
+        {
+            for (size_t i = 0; i < samples; i++) {
+                output[i] = filter(input[i]);
+            }
+        }
+
         virtual void reset() { }
 
+        /**
+         * Returns the biggest radius of the poles of this filter in the
+         * z-plane, or a negative value if that is not known.
+         */
+        virtual double getMaximumPoleRadius() const { return -1; }
+
         virtual ~Filter() = default;
 
         static Filter &identity()
@@ -65,16 +83,76 @@ namespace tdap::filter
                                                          double threshold,
                                                          size_t windowSize,
                                                          Filter &weighting = identity());
+
+        /**
+         * Returns the same as getEffectiveImpulseResponseLength(), but
+         * measures with denormal numbers flushed to zero, which otherwise
+         * dominate the cost of measuring long decays. If the maximum pole
+         * radius of the filter is one or bigger, the impulse response does
+         * not decay and this returns -1 without measuring.
+         */
+        static ssize_t getEffectiveImpulseResponseLengthFast(Filter &filter,
+                                                             size_t maxLength,
+                                                             double threshold,
+                                                             size_t windowSize,
+                                                             Filter &weighting = identity());
     };
 
+    template <typename T>
+    class ChannelFilterView;
+
     template <typename T>
     struct ChannelFilter
     {
         static_assert(std::is_arithmetic<T>::value);
 
-        virtual size_t getChannels() const;
+        virtual size_t getChannels() const = 0;
+
+        virtual T filter([[maybe_unused]] const size_t channel, const T input) { return input; }
 
-        virtual T filter(const size_t channel, const T input) { return input; }
+        /**
+         * Filters a block of samples of a single channel from input to
+         * output, which may be the same. The default calls
+         * filter(channel, input) for each sample.
+         */
+        virtual void filter(const size_t channel, const T *input, T *output, size_t samples)
+        {
+            for (size_t i = 0; i < samples; i++) {
+                output[i] = filter(channel, input[i]);
+            }
+        }
+
+        /**
+         * Filters frames of getChannels() interleaved samples from input to
+         * output, which may be the same. The default calls
+         * filter(channel, input) for each sample, in the same order as
+         * filtering frame by frame.
+         */
+        virtual void filter(const T *input, T *output, size_t frames)
+        {
+            const size_t channels = getChannels();
+            for (size_t frame = 0, i = 0; frame < frames; frame++) {
+                for (size_t channel = 0; channel < channels; channel++, i++) {
+                    output[i] = filter(channel, input[i]);
+                }
+            }
+        }
+
+        /**
+         * Filters frames of samples from the getChannels() planar input
+         * buffers to the output buffers, which may be the same. The default
+         * calls filter(channel, input) for each sample, in the same order as
+         * filtering frame by frame.
+         */
+        virtual void filter(const T * const *input, T * const *output, size_t frames)
+        {
+            const size_t channels = getChannels();
+            for (size_t frame = 0; frame < frames; frame++) {
+                for (size_t channel = 0; channel < channels; channel++) {
+                    output[channel][frame] = filter(channel, input[channel][frame]);
+                }
+            }
+        }
 
         virtual void reset() { }
 
@@ -86,7 +164,43 @@ namespace tdap::filter
          *
          * @return the Filter.
          */
-        Filter<T> single();
+        ChannelFilterView<T> single();
+
+        /**
+         * Returns a Filter that uses the given channel of this ChannelFilter
+         * and ignores resets.
+         *
+         * @return the Filter.
+         */
+        ChannelFilterView<T> channel(size_t channel);
+    };
+
+    /**
+     * A Filter that uses a single channel of a ChannelFilter, that must
+     * outlive the view. The view refers to the channel filter, so it does
+     * not allocate and it can be copied. Resets are ignored, as they would
+     * affect all channels.
+     */
+    template <typename T>
+    class ChannelFilterView : public Filter<T>
+    {
+        ChannelFilter<T> *filter_;
+        size_t channel_;
+
+    public:
+        ChannelFilterView(ChannelFilter<T> &filter, size_t channel);
+
+        size_t getChannel() const { return channel_; }
+
+        T filter(const T input) override
+        {
+            return filter_->filter(channel_, input);
+        }
+
+        void filter(const T *input, T *output, size_t samples) override
+        {
+            filter_->filter(channel_, input, output, samples);
+        }
     };
 
 }
@@ -21,8 +21,13 @@
  * limitations under the License.
  */
 
+#include <cstdint>
 #include <limits>
+#include <stdexcept>
 #include <tdap/boundaries.hpp>
+#include <tdap/buffer.hpp>
+#include <tdap/macros.hpp>
+#include <tdap/power2.hpp>
 
 namespace tdap::average::helper {
 
@@ -88,16 +93,105 @@ namespace tdap::average::helper {
         static size_t validErrorMitigatingDecaySamples(size_t samples);
     };
 
+    /**
+     * Calculates the input and history factors for a window of windowSamples
+     * samples, given the error mitigating decay in samples and its factor.
+     */
     template<typename S>
+    inline void getWindowFactorsForEmd(
+            S emdFactor, size_t emdSamples, size_t windowSamples,
+            S &inputFactor, S &historyFactor);
+
+    /**
+     * Resizes a history ring of frames of channels values from oldSize to
+     * newSize frames, where the write pointer moves down, so that the frame
+     * k frames old is at (writePtr + k) modulo the size. The frames that
+     * remain keep their age and if the ring grows, the older frames that it
+     * did not hold are set to fillValues. Returns the new write pointer.
+     */
+    template<typename S>
+    inline size_t resizeHistoryKeepingAge(
+            S *history, size_t channels, size_t writePtr,
+            size_t oldSize, size_t newSize, const S *fillValues);
+
+    /**
+     * Adds value to sum and returns the rounding error of that addition
+     * exactly (Knuth's two-sum). Unlike Kahan and Neumaier summation, this has
+     * no branches, so it maps to vector lanes. It relies on strict IEEE
+     * evaluation, so it must not be compiled with fast-math.
+     */
+    template<typename S>
+    inline S addGetError(S &sum, S value)
+    {
+        const S result = sum + value;
+        const S virtualValue = result - sum;
+        const S error = (sum - (result - virtualValue)) + (value - virtualValue);
+        sum = result;
+        return error;
+    }
+
+    /**
+     * Returns size if it lies between 1 and maximum and throws
+     * std::invalid_argument with message otherwise.
+     */
+    inline size_t validHistorySize(size_t size, size_t maximum, const char *message)
+    {
+        if (is_between(size, 1, maximum)) {
+            return size;
+        }
+        throw std::invalid_argument(message);
+    }
+
+    /**
+     * Calls add with a pointer to each frame of channels values of a window
+     * of frames in a history ring of size frames, where the write pointer
+     * moves down. The window consists of the frames after the write pointer,
+     * up to and including the read pointer of the window.
+     */
+    template<typename S, class ADD>
+    inline void forEachWindowFrame(
+            const S *history, size_t channels, size_t size, size_t writePtr,
+            size_t frames, ADD add)
+    {
+        for (size_t i = 1, ptr = writePtr; i <= frames; i++) {
+            ptr = ptr < size - 1 ? ptr + 1 : 0;
+            add(history + ptr * channels);
+        }
+    }
+
+    /**
+     * Returns the sum in type A of a window of samples in a history ring.
+     * @see forEachWindowFrame()
+     */
+    template<typename A, typename S>
+    inline A windowSum(const S *history, size_t size, size_t writePtr, size_t samples)
+    {
+        A sum = 0;
+        forEachWindowFrame(history, 1, size, writePtr, samples, [&sum](const S *value) {
+            sum += *value;
+        });
+        return sum;
+    }
+
+    /**
+     * History of samples that is shared by one or more windows. Only the
+     * active part of the history, that is big enough for the biggest window,
+     * is used. If POWER2_HISTORY is true, the capacity and the active part
+     * are a power of two, so that pointers wrap around with a mask.
+     */
+    template<typename S, bool POWER2_HISTORY = false>
     class BaseHistoryAndEmdForTrueFloatingPointMovingAverage
     {
         const size_t historySamples_;
-        S * const history_;
+        const size_t capacity_;
+        Buffer<S> history_;
         const size_t emdSamples_;
         const S emdFactor_;
         size_t historyEndPtr_;
         size_t writePtr_ = 0;
 
+        static size_t capacityFor(size_t historySamples);
+
     protected:
         BaseHistoryAndEmdForTrueFloatingPointMovingAverage(
                 const size_t historySamples, const size_t emdSamples);
@@ -106,13 +200,47 @@ namespace tdap::average::helper {
     public:
 
         size_t historySize() const { return historySamples_; }
+        size_t capacity() const { return capacity_; }
         size_t emdSamples() const { return emdSamples_; }
         size_t writePtr() const { return writePtr_; }
         size_t maxWindowSamples() const { return historyEndPtr_ + 1; }
         S emdFactor() const { return emdFactor_; }
 
+        /**
+         * Calculates the input and history factors for a window of
+         * windowSamples samples, given the error mitigating decay.
+         */
+        void getWindowFactors(
+                size_t windowSamples, S &inputFactor, S &historyFactor) const;
+
         inline size_t getRelative(size_t delta) const;
         const S getHistoryValue(size_t &readPtr) const;
+
+        /**
+         * Moves the read pointer one sample back in time and returns the
+         * value there: the reverse of getHistoryValue().
+         */
+        const S getOlderHistoryValue(size_t &readPtr) const;
+
+        /**
+         * Returns the number of samples that can be read or written starting
+         * at ptr, before that pointer wraps around.
+         */
+        size_t samplesBeforeWrap(size_t ptr) const { return ptr + 1; }
+
+        /**
+         * Moves the read pointer samples positions, where samples cannot be
+         * larger than samplesBeforeWrap(readPtr).
+         */
+        inline void skipHistoryValues(size_t &readPtr, size_t samples) const;
+
+        /**
+         * Returns the write position and moves the write pointer samples
+         * positions, where samples cannot be larger than
+         * samplesBeforeWrap(writePtr()). Values must be written backwards
+         * from the returned position.
+         */
+        S *writeBlock(size_t samples);
         const S get(size_t index) const;
         const S get() const;
         const S operator[](size_t index) const;
@@ -120,32 +248,47 @@ namespace tdap::average::helper {
         void write(S value);
         S &operator[](size_t index);
         void fillWithAverage(const S average);
-        const S * const history() const { return history_; }
-        S * const history() { return history_; }
-
-        bool optimiseForMaximumWindowSamples(size_t samples);
-
-        ~BaseHistoryAndEmdForTrueFloatingPointMovingAverage();
+        const S * const history() const { return history_.data(); }
+        S * const history() { return history_.data(); }
+
+        /**
+         * Makes the active history just big enough for windows of samples.
+         * The values that remain in the active history keep their age and
+         * if it grows, the older values that it did not hold are set to
+         * fillValue. Returns whether the active history changed, so read
+         * pointers must be set again.
+         */
+        bool optimiseForMaximumWindowSamples(size_t samples, S fillValue);
+
+        /**
+         * Does the same as optimiseForMaximumWindowSamples(), but only if
+         * that makes the active history bigger.
+         */
+        bool extendForWindowSamples(size_t samples, S fillValue);
     };
 
-    template<typename S>
+    template<typename S, bool POWER2_HISTORY = false>
     class WindowForTrueFloatingPointMovingAverage
     {
-        const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S> * history_ = nullptr;
+        const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> * history_ = nullptr;
         size_t windowSamples_ = 1;
         S inputFactor_ = 1;
         S historyFactor_ = 1;
+        // The history decay of the window, historyFactor_ / inputFactor_
+        S windowDecay_ = 1;
         size_t readPtr_ = 1;
         S average_ = 0;
+        size_t targetWindowSamples_ = 1;
+        size_t rampSamples_ = 0;
 
     public:
         WindowForTrueFloatingPointMovingAverage() {}
         WindowForTrueFloatingPointMovingAverage(
-                const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S> *history);
+                const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *history);
 
-        void setOwner(const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S> *history);
+        void setOwner(const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *history);
 
-        bool isOwnedBy(const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S> *owner) const;
+        bool isOwnedBy(const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *owner) const;
 
         S getAverage() const { return average_; }
 
@@ -153,26 +296,63 @@ namespace tdap::average::helper {
 
         size_t getReadPtr() const { return readPtr_; }
 
-        const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S> * owner() const { return history_; }
+        const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> * owner() const { return history_; }
 
         void setAverage(S average);
         void setWindowSamples(size_t windowSamples);
         void setReadPtr();
 
+        /**
+         * Changes the window size and corrects the average, so that it is
+         * the average of the new window, as if it had always had that size.
+         * This adds or removes the history values between the old and the
+         * new window size, so the window size must fit the active history.
+         * While ramping, the factors are derived from the decay that is
+         * updated per added or removed value, instead of with exp(); they
+         * are calculated exactly when the ramp ends.
+         */
+        void adjustWindowSamples(size_t windowSamples);
+
+        /**
+         * Glides the window size to windowSamples over rampSamples samples,
+         * using adjustWindowSamples() in each call to advanceRamp(). If
+         * rampSamples is zero, the window size is adjusted immediately.
+         */
+        void rampWindowSamples(size_t windowSamples, size_t rampSamples);
+
+        bool isRamping() const { return rampSamples_ != 0; }
+
+        /**
+         * Advances an ongoing ramp by samples, adjusting the window size to
+         * the size that is interpolated for the end of those samples.
+         */
+        void advanceRamp(size_t samples);
+
         void addInput(S input);
+
+        /**
+         * Adds the inputs and writes the resulting averages to output. The
+         * inputs are written backwards from write, interleaved with reading
+         * history, so the result is identical to calling addInput() and
+         * writing history for each sample separately. Neither the read
+         * pointer, nor the write position can wrap within samples.
+         */
+        void addInputs(const S *input, S *output, S *write, size_t samples);
     };
 
-    template<typename S>
+    template<typename S, bool POWER2_HISTORY = false>
     class ScaledWindowForTrueFloatingPointMovingAverage :
-            public WindowForTrueFloatingPointMovingAverage<S>
+            public WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>
     {
-        using Super = WindowForTrueFloatingPointMovingAverage<S>;
+        using Super = WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>;
         S scale_ = 1;
     public:
         ScaledWindowForTrueFloatingPointMovingAverage() { }
 
         ScaledWindowForTrueFloatingPointMovingAverage(
-                const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S> &history);
+                const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> &history);
+
+        static S limitedScale(S scale);
 
         S setScale(S scale);
 
@@ -184,15 +364,126 @@ namespace tdap::average::helper {
 
         void setOutput(S outputValue);
     };
+
+    /**
+     * A set of scaled windows that share the same history. The window state
+     * is stored as a structure of arrays. As all read pointers move together
+     * with the write pointer of the history, each window only keeps its
+     * distance to that pointer, as a 32-bit offset. That makes the wrapped
+     * read position a vector compare and subtract, so that reading the
+     * history, updating the averages and taking their maximum happen in a
+     * single loop that vectorizes; the compiler emulates the gather with
+     * scalar loads into vector registers.
+     *
+     * @tparam S the type of samples used
+     * @tparam MAX_WINDOWS the maximum number of windows in the set
+     */
+    template<typename S, size_t MAX_WINDOWS, bool POWER2_HISTORY = false>
+    class ScaledWindowSetForTrueFloatingPointMovingAverage
+    {
+        static constexpr size_t ALIGN = 64;
+        static constexpr size_t LANES = ALIGN / sizeof(S);
+        using Offset = uint32_t;
+
+        const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> * const history_;
+        alignas(ALIGN) S inputFactor_[MAX_WINDOWS];
+        alignas(ALIGN) S historyFactor_[MAX_WINDOWS];
+        alignas(ALIGN) S average_[MAX_WINDOWS];
+        alignas(ALIGN) S scale_[MAX_WINDOWS];
+        alignas(ALIGN) Offset readOffset_[MAX_WINDOWS];
+        size_t windowSamples_[MAX_WINDOWS];
+
+        static const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *
+        validHistory(const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *history);
+
+        static inline Offset wrap(Offset ptr, Offset size);
+
+    public:
+        explicit ScaledWindowSetForTrueFloatingPointMovingAverage(
+                const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *history);
+
+        size_t windowSamples(size_t index) const { return windowSamples_[index]; }
+
+        S scale(size_t index) const { return scale_[index]; }
+
+        size_t getReadPtr(size_t index) const { return history_->getRelative(readOffset_[index]); }
+
+        S getAverage(size_t index) const { return scale_[index] * average_[index]; }
+
+        S getUnscaledAverage(size_t index) const { return average_[index]; }
+
+        void setAverage(size_t index, S average) { average_[index] = average; }
+
+        void setWindowSamplesAndScale(size_t index, size_t windowSamples, S scale);
+
+        /**
+         * Sets window samples, scale and factors that were calculated before
+         * with the history's getWindowFactors(), without validation and
+         * without setting the read pointer.
+         */
+        void setWindow(size_t index, size_t windowSamples, S scale,
+                       S inputFactor, S historyFactor);
+
+        void setReadPtr(size_t index);
+
+        void addInput(S input, size_t windows) TDAP_RESTRICT_THIS;
+
+        S addInputGetMax(S input, S minimumValue, size_t windows) TDAP_RESTRICT_THIS;
+    };
+    /**
+     * History with a capacity that is known at compile time and that is
+     * stored inline, so that it needs no heap allocation. If the capacity is
+     * rounded up to a power of two, pointers wrap around with a mask.
+     *
+     * @tparam S the type of samples used
+     * @tparam MAX_SAMPLES the minimum capacity in samples
+     * @tparam POWER2_CAPACITY whether to round the capacity up to a power of two
+     */
+    template<typename S, size_t MAX_SAMPLES, bool POWER2_CAPACITY>
+    class FixedHistoryForTrueFloatingPointMovingAverage
+    {
+    public:
+        static constexpr size_t CAPACITY = POWER2_CAPACITY ?
+                                           Power2::constant::next(MAX_SAMPLES) :
+                                           MAX_SAMPLES;
+        static constexpr size_t MASK = CAPACITY - 1;
+
+    private:
+        Array<S, CAPACITY> history_;
+        size_t writePtr_ = 0;
+
+    public:
+        static constexpr size_t samplesBeforeWrap(size_t ptr) { return ptr + 1; }
+
+        static inline void setNextPtr(size_t &ptr);
+
+        static inline void skipHistoryValues(size_t &ptr, size_t samples);
+
+        size_t writePtr() const { return writePtr_; }
+
+        inline size_t getRelative(size_t delta) const;
+
+        const S getHistoryValue(size_t &readPtr) const;
+
+        const S * history() const { return history_.data(); }
+
+        void write(S value);
+
+        S *writeBlock(size_t samples);
+
+        void fillWithAverage(const S average);
+    };
+
     template<
             typename S, size_t SNR_BITS = 20,
-            size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO = 10>
+            size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO = 10,
+            bool POWER2_HISTORY = false>
     class HistoryAndEmdForTrueFloatingPointMovingAverage :
-            public BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>
+            public BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>
     {
         using Metrics_ = HelperForMovingAverageMetricsForInaccurateTypes
                 <S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>;
-        using Super = BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>;
+        using Super = BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>;
 
         static size_t validWindowSize(size_t emdSamples, size_t windowSize);
 
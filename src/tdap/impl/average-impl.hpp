@@ -22,8 +22,10 @@
  */
 
 
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <cstring>
 
 namespace tdap::average::helper
 {
@@ -109,40 +111,131 @@ namespace tdap::average::helper
 
 
     template<typename S>
-    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<
-            S>::BaseHistoryAndEmdForTrueFloatingPointMovingAverage(
+    void getWindowFactorsForEmd(
+            S emdFactor, size_t emdSamples, size_t windowSamples,
+            S &inputFactor, S &historyFactor)
+    {
+        const double unscaledHistoryDecayFactor =
+                exp(-1.0 * windowSamples / emdSamples);
+        inputFactor = (1.0 - emdFactor) / (1.0 - unscaledHistoryDecayFactor);
+        historyFactor = inputFactor * unscaledHistoryDecayFactor;
+    }
+
+    template<typename S>
+    size_t resizeHistoryKeepingAge(
+            S *history, size_t channels, size_t writePtr,
+            size_t oldSize, size_t newSize, const S *fillValues)
+    {
+        if (newSize > oldSize) {
+            // The frames that wrapped around, in [0, writePtr], move up by
+            // the old size. Going up, a frame that wraps again in the new
+            // size moves to a position that was already moved.
+            for (size_t i = 0; i <= writePtr; i++) {
+                const size_t moved = i + oldSize;
+                std::copy_n(history + i * channels, channels,
+                            history + (moved < newSize ? moved : moved - newSize) * channels);
+            }
+            for (size_t age = oldSize + 1; age <= newSize; age++) {
+                const size_t ptr = writePtr + age;
+                std::copy_n(fillValues, channels,
+                            history + (ptr < newSize ? ptr : ptr - newSize) * channels);
+            }
+            return writePtr;
+        }
+        if (newSize == oldSize) {
+            return writePtr;
+        }
+        // The frames that are 1 up to the new size old are kept
+        const size_t newest = writePtr + 1 < oldSize ? writePtr + 1 : 0;
+        const size_t unwrapped = oldSize - newest;
+        if (unwrapped >= newSize) {
+            // They do not wrap around: move them to the start
+            std::copy(history + newest * channels, history + (newest + newSize) * channels, history);
+            return newSize - 1;
+        }
+        // The frames that wrapped around stay at the start and the newest
+        // ones move down to the new end
+        std::copy(history + newest * channels, history + oldSize * channels,
+                  history + (newSize - unwrapped) * channels);
+        return newSize - unwrapped - 1;
+    }
+
+    template<typename S, bool POWER2_HISTORY>
+    size_t BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::capacityFor(
+            size_t historySamples)
+    {
+        if constexpr (POWER2_HISTORY) {
+            return Power2::next(historySamples);
+        }
+        else {
+            return historySamples;
+        }
+    }
+
+    template<typename S, bool POWER2_HISTORY>
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::BaseHistoryAndEmdForTrueFloatingPointMovingAverage(
             const size_t historySamples, const size_t emdSamples)
             :
             historySamples_(historySamples),
-            history_(new S[historySamples]),
+            capacity_(capacityFor(historySamples)),
+            history_(capacity_),
             emdSamples_(emdSamples),
             emdFactor_(exp( -1.0 / emdSamples)),
-            historyEndPtr_(historySamples - 1),
+            historyEndPtr_(capacity_ - 1),
             writePtr_(0)
     {}
 
-    template<typename S>
-    void BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::setNextPtr(
+    template<typename S, bool POWER2_HISTORY>
+    void BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::setNextPtr(
             size_t &ptr) const
     {
-        if (ptr > 0) {
+        if constexpr (POWER2_HISTORY) {
+            ptr = (ptr - 1) & historyEndPtr_;
+        }
+        else if (ptr > 0) {
             ptr--;
         }
         else
             ptr = historyEndPtr_;
     }
 
-    template<typename S>
+    template<typename S, bool POWER2_HISTORY>
     size_t
-    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::getRelative(
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::getRelative(
             size_t delta) const
     {
-        return (writePtr_ + delta) % (historyEndPtr_ + 1);
+        if constexpr (POWER2_HISTORY) {
+            return (writePtr_ + delta) & historyEndPtr_;
+        }
+        else {
+            return (writePtr_ + delta) % (historyEndPtr_ + 1);
+        }
+    }
+
+    template<typename S, bool POWER2_HISTORY>
+    void BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::skipHistoryValues(
+            size_t &readPtr, size_t samples) const
+    {
+        if constexpr (POWER2_HISTORY) {
+            readPtr = (readPtr - samples) & historyEndPtr_;
+        }
+        else {
+            readPtr = readPtr >= samples ? readPtr - samples : historyEndPtr_;
+        }
     }
 
-    template<typename S>
+    template<typename S, bool POWER2_HISTORY>
+    S *BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::writeBlock(
+            size_t samples)
+    {
+        S *result = history_.data() + writePtr_;
+        skipHistoryValues(writePtr_, samples);
+        return result;
+    }
+
+    template<typename S, bool POWER2_HISTORY>
     const S
-    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::getHistoryValue(
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::getHistoryValue(
             size_t &readPtr) const
     {
         S result = history_[readPtr];
@@ -150,97 +243,116 @@ namespace tdap::average::helper
         return result;
     }
 
-    template<typename S>
-    const S BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::get(
+    template<typename S, bool POWER2_HISTORY>
+    const S
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::getOlderHistoryValue(
+            size_t &readPtr) const
+    {
+        if constexpr (POWER2_HISTORY) {
+            readPtr = (readPtr + 1) & historyEndPtr_;
+        }
+        else {
+            readPtr = readPtr < historyEndPtr_ ? readPtr + 1 : 0;
+        }
+        return history_[readPtr];
+    }
+
+    template<typename S, bool POWER2_HISTORY>
+    const S BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::get(
             size_t index) const
     {
         return history_[IndexPolicy::NotGreater::method(index, historyEndPtr_)];
     }
 
-    template<typename S>
+    template<typename S, bool POWER2_HISTORY>
     const S
-    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::get() const
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::get() const
     {
         return get(writePtr_);
     }
 
-    template<typename S>
+    template<typename S, bool POWER2_HISTORY>
     const S
-    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::operator[](
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::operator[](
             size_t index) const
     {
         return history_[IndexPolicy::NotGreater::array(index, historyEndPtr_)];
     }
 
-    template<typename S>
+    template<typename S, bool POWER2_HISTORY>
     void
-    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::set(size_t index,
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::set(size_t index,
                                                                S value)
     {
         history_[IndexPolicy::NotGreater::method(index, historyEndPtr_)] = value;
     }
 
-    template<typename S>
+    template<typename S, bool POWER2_HISTORY>
     void
-    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::write(S value)
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::write(S value)
     {
         history_[writePtr_] = value;
         setNextPtr(writePtr_);
     }
 
-    template<typename S>
-    S &BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::operator[](
+    template<typename S, bool POWER2_HISTORY>
+    S &BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::operator[](
             size_t index)
     {
         return history_[IndexPolicy::NotGreater::array(index, historyEndPtr_)];
     }
 
-    template<typename S>
-    bool BaseHistoryAndEmdForTrueFloatingPointMovingAverage<
-            S>::optimiseForMaximumWindowSamples(size_t samples)
+    template<typename S, bool POWER2_HISTORY>
+    bool BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::optimiseForMaximumWindowSamples(
+            size_t samples, S fillValue)
     {
-        size_t newHistoryEnd =
-                force_between(samples, 4, maxWindowSamples()) - 1;
-        if (newHistoryEnd != historyEndPtr_) {
-            historyEndPtr_ = newHistoryEnd;
-            return true;
+        const size_t oldSize = historyEndPtr_ + 1;
+        const size_t newSize = capacityFor(force_between(samples, 4, historySamples_));
+        if (newSize == oldSize) {
+            return false;
         }
-        return false;
+        writePtr_ = resizeHistoryKeepingAge(
+                history_.data(), 1, writePtr_, oldSize, newSize, &fillValue);
+        historyEndPtr_ = newSize - 1;
+        return true;
     }
 
-    template<typename S>
-    void
-    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S>::fillWithAverage(
-            const S average)
+    template<typename S, bool POWER2_HISTORY>
+    bool BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::extendForWindowSamples(
+            size_t samples, S fillValue)
     {
-        for (size_t i = 0; i <= historyEndPtr_; i++) {
-            history_[i] = average;
-        }
+        return capacityFor(force_between(samples, 4, historySamples_)) > historyEndPtr_ + 1 &&
+               optimiseForMaximumWindowSamples(samples, fillValue);
     }
 
-    template<typename S>
-    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<
-            S>::~BaseHistoryAndEmdForTrueFloatingPointMovingAverage()
+    template<typename S, bool POWER2_HISTORY>
+    void
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::getWindowFactors(
+            size_t windowSamples, S &inputFactor, S &historyFactor) const
     {
-        delete[] history_;
+        getWindowFactorsForEmd(
+                emdFactor_, emdSamples_, windowSamples, inputFactor, historyFactor);
     }
 
+    template<typename S, bool POWER2_HISTORY>
+    void
+    BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::fillWithAverage(
+            const S average)
+    {
+        history_.fill(average);
+    }
 
-
-    template<typename S>
-    WindowForTrueFloatingPointMovingAverage<
-            S>::WindowForTrueFloatingPointMovingAverage(
-            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<
-            S> *history)
+    template<typename S, bool POWER2_HISTORY>
+    WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::WindowForTrueFloatingPointMovingAverage(
+            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *history)
             :
             history_(history)
     {
     }
 
-    template<typename S>
-    void WindowForTrueFloatingPointMovingAverage<S>::setOwner(
-            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<
-            S> *history)
+    template<typename S, bool POWER2_HISTORY>
+    void WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::setOwner(
+            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *history)
     {
         if (history_ == nullptr) {
             history_ = history;
@@ -249,41 +361,124 @@ namespace tdap::average::helper
         throw std::runtime_error("Window already owned by other history");
     }
 
-    template<typename S>
-    bool WindowForTrueFloatingPointMovingAverage<S>::isOwnedBy(
-            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<
-            S> *owner) const
+    template<typename S, bool POWER2_HISTORY>
+    bool WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::isOwnedBy(
+            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *owner) const
     {
         bool b = owner == history_;
         return b;
     }
 
-    template<typename S>
-    void WindowForTrueFloatingPointMovingAverage<S>::setAverage(S average)
+    template<typename S, bool POWER2_HISTORY>
+    void WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::setAverage(S average)
     {
         average_ = average;
     }
 
-    template<typename S>
-    void WindowForTrueFloatingPointMovingAverage<S>::setWindowSamples(
+    template<typename S, bool POWER2_HISTORY>
+    void WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::setWindowSamples(
             size_t windowSamples)
     {
         if (history_ == nullptr) {
             throw std::runtime_error("WindowForTrueFloatingPointMovingAverage::setWindowSamples(): window not related to history data");
         }
-        if (!is_between(windowSamples, 1, history_->maxWindowSamples())) {
+        if (!is_between(windowSamples, 1, history_->historySize())) {
             throw std::runtime_error("WindowForTrueFloatingPointMovingAverage: window samples must lie between 1 and history's maximum size");
         }
         windowSamples_ = windowSamples;
-        const double unscaledHistoryDecayFactor =
-                exp(-1.0 * this->windowSamples_ / history_->emdSamples());
-        inputFactor_ = (1.0 - history_->emdFactor()) / (1.0 - unscaledHistoryDecayFactor);
-        historyFactor_ = inputFactor_ * unscaledHistoryDecayFactor;
-        setReadPtr();
+        rampSamples_ = 0;
+        history_->getWindowFactors(windowSamples_, inputFactor_, historyFactor_);
+        windowDecay_ = historyFactor_ / inputFactor_;
+        if (windowSamples_ <= history_->maxWindowSamples()) {
+            setReadPtr();
+        }
     }
 
-    template<typename S>
-    void WindowForTrueFloatingPointMovingAverage<S>::setReadPtr()
+    template<typename S, bool POWER2_HISTORY>
+    void WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::adjustWindowSamples(
+            size_t windowSamples)
+    {
+        if (!is_between(windowSamples, 1, history_->maxWindowSamples())) {
+            throw std::runtime_error("WindowForTrueFloatingPointMovingAverage: adjusted window samples must lie between 1 and history's active size");
+        }
+        // The average is inputFactor times the sum of the window's values,
+        // where the value k samples in the past is weighted by emdFactor^k.
+        // As inputFactor is (1 - emdFactor) / (1 - windowDecay), the sum is
+        // kept multiplied by (1 - emdFactor), so that only the new input
+        // factor needs a division.
+        const S emdFactor = history_->emdFactor();
+        const S emdComplement = 1 - emdFactor;
+        const S oldDecayComplement = 1 - windowDecay_;
+        S decay = windowDecay_;
+        S delta = 0;
+        if (windowSamples_ < windowSamples) {
+            for (; windowSamples_ < windowSamples; windowSamples_++) {
+                delta += decay * history_->getOlderHistoryValue(readPtr_);
+                decay *= emdFactor;
+            }
+        }
+        else if (windowSamples_ > windowSamples) {
+            const S inverseEmdFactor = 1 / emdFactor;
+            for (; windowSamples_ > windowSamples; windowSamples_--) {
+                decay *= inverseEmdFactor;
+                delta -= decay * history_->getHistoryValue(readPtr_);
+            }
+        }
+        if (rampSamples_ != 0) {
+            windowDecay_ = decay;
+            const S reciprocal = 1 / (1 - windowDecay_);
+            inputFactor_ = emdComplement * reciprocal;
+            historyFactor_ = inputFactor_ * windowDecay_;
+            average_ = reciprocal * (oldDecayComplement * average_ + emdComplement * delta);
+        }
+        else {
+            const S sum = average_ / inputFactor_ + delta;
+            history_->getWindowFactors(windowSamples_, inputFactor_, historyFactor_);
+            windowDecay_ = historyFactor_ / inputFactor_;
+            average_ = inputFactor_ * sum;
+        }
+    }
+
+    template<typename S, bool POWER2_HISTORY>
+    void WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::rampWindowSamples(
+            size_t windowSamples, size_t rampSamples)
+    {
+        if (!is_between(windowSamples, 1, history_->maxWindowSamples())) {
+            throw std::runtime_error("WindowForTrueFloatingPointMovingAverage: ramped window samples must lie between 1 and history's active size");
+        }
+        targetWindowSamples_ = windowSamples;
+        rampSamples_ = rampSamples;
+        if (rampSamples_ == 0) {
+            adjustWindowSamples(targetWindowSamples_);
+        }
+    }
+
+    template<typename S, bool POWER2_HISTORY>
+    void WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::advanceRamp(
+            size_t samples)
+    {
+        if (rampSamples_ == 0) {
+            return;
+        }
+        if (samples >= rampSamples_) {
+            rampSamples_ = 0;
+            adjustWindowSamples(targetWindowSamples_);
+            return;
+        }
+        const ptrdiff_t distance =
+                static_cast<ptrdiff_t>(targetWindowSamples_) -
+                static_cast<ptrdiff_t>(windowSamples_);
+        const ptrdiff_t step =
+                distance * static_cast<ptrdiff_t>(samples) /
+                static_cast<ptrdiff_t>(rampSamples_);
+        rampSamples_ -= samples;
+        if (step != 0) {
+            adjustWindowSamples(windowSamples_ + step);
+        }
+    }
+
+    template<typename S, bool POWER2_HISTORY>
+    void WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::setReadPtr()
     {
         if (windowSamples_ <= history_->maxWindowSamples()) {
             readPtr_ = history_->getRelative(windowSamples_);
@@ -292,8 +487,8 @@ namespace tdap::average::helper
         throw std::runtime_error("RMS window size cannot be bigger than buffer");
     }
 
-    template<typename S>
-    void WindowForTrueFloatingPointMovingAverage<S>::addInput(S input)
+    template<typename S, bool POWER2_HISTORY>
+    void WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::addInput(S input)
     {
         S history = history_->getHistoryValue(readPtr_);
         average_ =
@@ -302,63 +497,294 @@ namespace tdap::average::helper
                 historyFactor_ * history;
     }
 
+    template<typename S, bool POWER2_HISTORY>
+    void WindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::addInputs(
+            const S *input, S *output, S *write, size_t samples)
+    {
+        const S *read = history_->history() + readPtr_;
+        const S emdFactor = history_->emdFactor();
+        S average = average_;
+        for (size_t i = 0; i < samples; i++) {
+            const S value = input[i];
+            average =
+                    emdFactor * average +
+                    inputFactor_ * value -
+                    historyFactor_ * *(read - i);
+            *(write - i) = value;
+            output[i] = average;
+        }
+        average_ = average;
+        history_->skipHistoryValues(readPtr_, samples);
+    }
 
-    template<typename S>
-    ScaledWindowForTrueFloatingPointMovingAverage<
-            S>::ScaledWindowForTrueFloatingPointMovingAverage(
-            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<
-            S> &history)
+
+    template<typename S, bool POWER2_HISTORY>
+    ScaledWindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::ScaledWindowForTrueFloatingPointMovingAverage(
+            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> &history)
             :
             Super(&history)
     {
     }
 
-    template<typename S>
-    S ScaledWindowForTrueFloatingPointMovingAverage<S>::setScale(S scale)
+    template<typename S, bool POWER2_HISTORY>
+    S ScaledWindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::limitedScale(S scale)
     {
         if (fabs(scale) < 1e-12) {
-            scale_ = 0.0;
+            return 0.0;
         }
         else if (scale > 1e12) {
-            scale_ = scale;
+            return scale;
         }
         else if (scale < -1e12) {
-            scale_ = -1e12;
-        }
-        else {
-            scale_ = scale;
+            return -1e12;
         }
         return scale;
     }
 
-    template<typename S>
-    void ScaledWindowForTrueFloatingPointMovingAverage<
-            S>::setWindowSamplesAndScale(size_t windowSamples, S scale)
+    template<typename S, bool POWER2_HISTORY>
+    S ScaledWindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::setScale(S scale)
+    {
+        scale_ = limitedScale(scale);
+        return scale;
+    }
+
+    template<typename S, bool POWER2_HISTORY>
+    void ScaledWindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::setWindowSamplesAndScale(size_t windowSamples, S scale)
     {
         Super::setWindowSamples(windowSamples);
         setScale(scale);
     }
 
-    template<typename S>
-    void ScaledWindowForTrueFloatingPointMovingAverage<S>::setOutput(
+    template<typename S, bool POWER2_HISTORY>
+    void ScaledWindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::setOutput(
             S outputValue)
     {
         Super::setAverage(scale_ != 0.0 ? outputValue / scale_ : outputValue);
     }
 
 
+    template<typename S, size_t MAX_WINDOWS, bool POWER2_HISTORY>
+    ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAX_WINDOWS, POWER2_HISTORY>::ScaledWindowSetForTrueFloatingPointMovingAverage(
+            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *history)
+            :
+            history_(validHistory(history))
+    {
+        for (size_t i = 0; i < MAX_WINDOWS; i++) {
+            inputFactor_[i] = 1;
+            historyFactor_[i] = 1;
+            average_[i] = 0;
+            scale_[i] = 1;
+            readOffset_[i] = 1;
+            windowSamples_[i] = 1;
+        }
+    }
+
+    template<typename S, size_t MAX_WINDOWS, bool POWER2_HISTORY>
+    void ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAX_WINDOWS, POWER2_HISTORY>::setWindowSamplesAndScale(
+            size_t index, size_t windowSamples, S scale)
+    {
+        if (!is_between(windowSamples, 1, history_->historySize())) {
+            throw std::runtime_error("ScaledWindowSetForTrueFloatingPointMovingAverage: window samples must lie between 1 and history's maximum size");
+        }
+        size_t i = IndexPolicy::method(index, MAX_WINDOWS);
+        windowSamples_[i] = windowSamples;
+        history_->getWindowFactors(windowSamples, inputFactor_[i], historyFactor_[i]);
+        scale_[i] = ScaledWindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::limitedScale(scale);
+        if (windowSamples <= history_->maxWindowSamples()) {
+            setReadPtr(i);
+        }
+    }
+
+    template<typename S, size_t MAX_WINDOWS, bool POWER2_HISTORY>
+    void ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAX_WINDOWS, POWER2_HISTORY>::setWindow(
+            size_t index, size_t windowSamples, S scale, S inputFactor, S historyFactor)
+    {
+        size_t i = IndexPolicy::method(index, MAX_WINDOWS);
+        windowSamples_[i] = windowSamples;
+        scale_[i] = scale;
+        inputFactor_[i] = inputFactor;
+        historyFactor_[i] = historyFactor;
+    }
+
+    template<typename S, size_t MAX_WINDOWS, bool POWER2_HISTORY>
+    void ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAX_WINDOWS, POWER2_HISTORY>::setReadPtr(
+            size_t index)
+    {
+        size_t i = IndexPolicy::method(index, MAX_WINDOWS);
+        if (windowSamples_[i] <= history_->maxWindowSamples()) {
+            readOffset_[i] = windowSamples_[i];
+            return;
+        }
+        throw std::runtime_error("RMS window size cannot be bigger than buffer");
+    }
+
+    template<typename S, size_t MAX_WINDOWS, bool POWER2_HISTORY>
+    const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *
+    ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAX_WINDOWS, POWER2_HISTORY>::validHistory(
+            const BaseHistoryAndEmdForTrueFloatingPointMovingAverage<S, POWER2_HISTORY> *history)
+    {
+        // The write pointer plus an offset must fit in an Offset
+        if (history->capacity() <= std::numeric_limits<Offset>::max() / 2) {
+            return history;
+        }
+        throw std::invalid_argument("ScaledWindowSetForTrueFloatingPointMovingAverage: history too big for 32-bit offsets");
+    }
+
+    template<typename S, size_t MAX_WINDOWS, bool POWER2_HISTORY>
+    typename ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAX_WINDOWS, POWER2_HISTORY>::Offset
+    ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAX_WINDOWS, POWER2_HISTORY>::wrap(
+            Offset ptr, Offset size)
+    {
+        if constexpr (POWER2_HISTORY) {
+            return ptr & (size - 1);
+        }
+        else {
+            return ptr < size ? ptr : ptr - size;
+        }
+    }
+
+    template<typename S, size_t MAX_WINDOWS, bool POWER2_HISTORY>
+    void ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAX_WINDOWS, POWER2_HISTORY>::addInput(
+            S input, size_t windows) TDAP_RESTRICT_THIS
+    {
+        const S * const history = history_->history();
+        const Offset writePtr = history_->writePtr();
+        const Offset size = history_->maxWindowSamples();
+        const S emdFactor = history_->emdFactor();
+        for (size_t i = 0; i < windows; i++) {
+            const S value = history[wrap(writePtr + readOffset_[i], size)];
+            average_[i] =
+                    emdFactor * average_[i] +
+                    inputFactor_[i] * input -
+                    historyFactor_[i] * value;
+        }
+    }
+
+    template<typename S, size_t MAX_WINDOWS, bool POWER2_HISTORY>
+    S ScaledWindowSetForTrueFloatingPointMovingAverage<S, MAX_WINDOWS, POWER2_HISTORY>::addInputGetMax(
+            S input, S minimumValue, size_t windows) TDAP_RESTRICT_THIS
+    {
+        const S * const history = history_->history();
+        const Offset writePtr = history_->writePtr();
+        const Offset size = history_->maxWindowSamples();
+        const S emdFactor = history_->emdFactor();
+        // Each maximum is that of its window and the windows LANES, 2 *
+        // LANES, ... before it. That dependency distance still allows the
+        // loop to be vectorized, while a plain reduction with the maximum
+        // does not, as that requires fast-math.
+        alignas(ALIGN) S maximum[MAX_WINDOWS + LANES];
+        for (size_t i = 0; i < LANES; i++) {
+            maximum[i] = minimumValue;
+        }
+        for (size_t i = 0; i < windows; i++) {
+            const S value = history[wrap(writePtr + readOffset_[i], size)];
+            const S average =
+                    emdFactor * average_[i] +
+                    inputFactor_[i] * input -
+                    historyFactor_[i] * value;
+            average_[i] = average;
+            const S scaled = scale_[i] * average;
+            maximum[i + LANES] = scaled > maximum[i] ? scaled : maximum[i];
+        }
+        // Lanes before LANES still hold the minimum value
+        const size_t lanes = windows < LANES ? windows : LANES;
+        const S * const laneMaximum = maximum + windows + LANES - lanes;
+        S result = minimumValue;
+        for (size_t lane = 0; lane < lanes; lane++) {
+            result = laneMaximum[lane] > result ? laneMaximum[lane] : result;
+        }
+        return result;
+    }
+
+
+    template<typename S, size_t MAX_SAMPLES, bool POWER2_CAPACITY>
+    void FixedHistoryForTrueFloatingPointMovingAverage<S, MAX_SAMPLES,
+                                                       POWER2_CAPACITY>::setNextPtr(
+            size_t &ptr)
+    {
+        if constexpr (POWER2_CAPACITY) {
+            ptr = (ptr - 1) & MASK;
+        }
+        else {
+            ptr = (ptr > 0 ? ptr : CAPACITY) - 1;
+        }
+    }
+
+    template<typename S, size_t MAX_SAMPLES, bool POWER2_CAPACITY>
+    void FixedHistoryForTrueFloatingPointMovingAverage<S, MAX_SAMPLES,
+                                                       POWER2_CAPACITY>::skipHistoryValues(
+            size_t &ptr, size_t samples)
+    {
+        if constexpr (POWER2_CAPACITY) {
+            ptr = (ptr - samples) & MASK;
+        }
+        else {
+            ptr = ptr >= samples ? ptr - samples : MASK;
+        }
+    }
+
+    template<typename S, size_t MAX_SAMPLES, bool POWER2_CAPACITY>
+    size_t FixedHistoryForTrueFloatingPointMovingAverage<S, MAX_SAMPLES,
+                                                         POWER2_CAPACITY>::getRelative(
+            size_t delta) const
+    {
+        if constexpr (POWER2_CAPACITY) {
+            return (writePtr_ + delta) & MASK;
+        }
+        else {
+            return (writePtr_ + delta) % CAPACITY;
+        }
+    }
+
+    template<typename S, size_t MAX_SAMPLES, bool POWER2_CAPACITY>
+    const S FixedHistoryForTrueFloatingPointMovingAverage<S, MAX_SAMPLES,
+                                                          POWER2_CAPACITY>::getHistoryValue(
+            size_t &readPtr) const
+    {
+        S result = history_[readPtr];
+        setNextPtr(readPtr);
+        return result;
+    }
+
+    template<typename S, size_t MAX_SAMPLES, bool POWER2_CAPACITY>
+    void FixedHistoryForTrueFloatingPointMovingAverage<S, MAX_SAMPLES,
+                                                       POWER2_CAPACITY>::write(
+            S value)
+    {
+        history_[writePtr_] = value;
+        setNextPtr(writePtr_);
+    }
+
+    template<typename S, size_t MAX_SAMPLES, bool POWER2_CAPACITY>
+    S *FixedHistoryForTrueFloatingPointMovingAverage<S, MAX_SAMPLES,
+                                                     POWER2_CAPACITY>::writeBlock(
+            size_t samples)
+    {
+        S *result = history_.data() + writePtr_;
+        skipHistoryValues(writePtr_, samples);
+        return result;
+    }
+
+    template<typename S, size_t MAX_SAMPLES, bool POWER2_CAPACITY>
+    void FixedHistoryForTrueFloatingPointMovingAverage<S, MAX_SAMPLES,
+                                                       POWER2_CAPACITY>::fillWithAverage(
+            const S average)
+    {
+        history_.fill(average);
+    }
+
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     HistoryAndEmdForTrueFloatingPointMovingAverage<S, SNR_BITS,
-                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::HistoryAndEmdForTrueFloatingPointMovingAverage(
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::HistoryAndEmdForTrueFloatingPointMovingAverage(
             const size_t historySamples, const size_t emdSamples) :
             Super(validWindowSize(Metrics_::validErrorMitigatingDecaySamples(emdSamples), historySamples), emdSamples)
     {}
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     size_t HistoryAndEmdForTrueFloatingPointMovingAverage<S, SNR_BITS,
-                                                          MIN_ERROR_DECAY_TO_WINDOW_RATIO>::validWindowSize(
+                                                          MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::validWindowSize(
             size_t emdSamples, size_t windowSize)
     {
         if (Metrics_::validWindowSizeInSamples(windowSize) < emdSamples / Metrics_::MIN_MIN_ERROR_DECAY_TO_WINDOW_RATIO) {
@@ -372,9 +798,9 @@ namespace tdap::average {
 
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     TrueFloatingPointWeightedMovingAverage<S, SNR_BITS,
-                                           MIN_ERROR_DECAY_TO_WINDOW_RATIO>::TrueFloatingPointWeightedMovingAverage(
+                                           MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::TrueFloatingPointWeightedMovingAverage(
             const size_t maxWindowSize, const size_t emdSamples)
             :
             history(maxWindowSize, emdSamples),
@@ -384,9 +810,9 @@ namespace tdap::average {
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     void TrueFloatingPointWeightedMovingAverage<S, SNR_BITS,
-                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setAverage(
+                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::setAverage(
             const double average)
     {
         window.setAverage(average);
@@ -394,32 +820,71 @@ namespace tdap::average {
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     void TrueFloatingPointWeightedMovingAverage<S, SNR_BITS,
-                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setWindowSize(
+                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::setWindowSize(
             const size_t windowSamples)
     {
+        // Older values that the active history did not keep are not known,
+        // so they are assumed to be equal to the current average
+        history.optimiseForMaximumWindowSamples(windowSamples, window.getAverage());
         window.setWindowSamples(windowSamples);
-        optimiseForMaximumSamples();
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
+    void TrueFloatingPointWeightedMovingAverage<S, SNR_BITS,
+                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::rampWindowSize(
+            const size_t windowSamples, const size_t rampSamples)
+    {
+        // Older values that the active history did not keep are not known,
+        // so they are assumed to be equal to the current average
+        if (history.extendForWindowSamples(windowSamples, window.getAverage())) {
+            window.setReadPtr();
+        }
+        window.rampWindowSamples(windowSamples, rampSamples);
+    }
+
+    template<
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     void TrueFloatingPointWeightedMovingAverage<S, SNR_BITS,
-                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO>::addInput(
+                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::addInput(
             const double input)
     {
+        if (window.isRamping()) {
+            window.advanceRamp(1);
+        }
         window.addInput(input);
         history.write(input);
     }
 
+    template<
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
+    void TrueFloatingPointWeightedMovingAverage<S, SNR_BITS,
+                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::addInputs(
+            const S *input, S *output, size_t samples)
+    {
+        if (window.isRamping()) {
+            window.advanceRamp(samples);
+        }
+        while (samples > 0) {
+            const size_t block = std::min(samples, std::min(
+                    history.samplesBeforeWrap(window.getReadPtr()),
+                    history.samplesBeforeWrap(history.writePtr())));
+            window.addInputs(input, output, history.writeBlock(block), block);
+            input += block;
+            output += block;
+            samples -= block;
+        }
+    }
+
 
 
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     size_t TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                     MIN_ERROR_DECAY_TO_WINDOW_RATIO>::validMaxTimeConstants(
+                                                     MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::validMaxTimeConstants(
             size_t constants)
     {
         if (is_between(constants, MINIMUM_TIME_CONSTANTS, MAXIMUM_TIME_CONSTANTS)) {
@@ -429,9 +894,9 @@ namespace tdap::average {
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     size_t TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                     MIN_ERROR_DECAY_TO_WINDOW_RATIO>::checkWindowIndex(
+                                                     MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::checkWindowIndex(
             size_t index) const
     {
         if (index < getUsedWindows()) {
@@ -441,49 +906,62 @@ namespace tdap::average {
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
-    void TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::optimiseForMaximumSamples()
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
+    bool TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::optimiseForMaximumSamples()
     {
-        size_t maximumSamples = 0;
-        for (size_t i = 0; i < usedWindows_; i++) {
-            maximumSamples = std::max(maximumSamples, entry_[i].windowSamples());
+        size_t longest = 0;
+        for (size_t i = 1; i < usedWindows_; i++) {
+            if (windows_.windowSamples(i) > windows_.windowSamples(longest)) {
+                longest = i;
+            }
         }
-        if (history_.optimiseForMaximumWindowSamples(maximumSamples)) {
+        // Older values that the active history did not keep are not known,
+        // so they are assumed to be equal to the average of the longest window
+        if (history_.optimiseForMaximumWindowSamples(
+                windows_.windowSamples(longest), windows_.getUnscaledAverage(longest))) {
             for (size_t i = 0; i < usedWindows_; i++) {
-                entry_[i].setReadPtr();
+                windows_.setReadPtr(i);
             }
+            return true;
         }
+        return false;
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                              MIN_ERROR_DECAY_TO_WINDOW_RATIO>::TrueFloatingPointWeightedMovingAverageSet(
+                                              MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::TrueFloatingPointWeightedMovingAverageSet(
             size_t maxWindowSamples, size_t errorMitigatingTimeConstant,
             size_t maxTimeConstants, S average) :
             entries_(validMaxTimeConstants(maxTimeConstants)),
-            entry_(new Window[entries_]),
             usedWindows_(entries_),
-            history_(maxWindowSamples, errorMitigatingTimeConstant)
+            history_(maxWindowSamples, errorMitigatingTimeConstant),
+            windows_(&history_)
     {
         history_.fillWithAverage(average);
+        draft_.usedWindows = usedWindows_;
         for (size_t i = 0; i < entries_; i++) {
-            entry_[i].setOwner(&history_);
-            entry_[i].setAverage(0);
-            entry_[i].setWindowSamplesAndScale((i + 1) * maxWindowSamples / entries_, 1.0);
+            windows_.setAverage(i, 0);
+            prepareWindowSizeAndScale(i, (i + 1) * maxWindowSamples / entries_, 1.0);
+            windows_.setWindowSamplesAndScale(i, draft_.windowSamples[i], draft_.scale[i]);
         }
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     void TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setUsedWindows(
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::setUsedWindows(
             size_t windows)
     {
         if (windows > 0 && windows <= getMaxWindows()) {
+            size_t previouslyUsed = usedWindows_;
             usedWindows_ = windows;
-            optimiseForMaximumSamples();
+            if (!optimiseForMaximumSamples()) {
+                for (size_t i = previouslyUsed; i < usedWindows_; i++) {
+                    windows_.setReadPtr(i);
+                }
+            }
         }
         else {
             throw std::out_of_range(
@@ -492,96 +970,1137 @@ namespace tdap::average {
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     void TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setWindowSizeAndScale(
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::setWindowSizeAndScale(
             size_t index, size_t windowSamples, S scale)
     {
-        if (windowSamples > getMaxWindowSamples()) {
-            throw std::out_of_range("Window size in samples is larger than configured maximum at construction.");
+        const size_t i = checkWindowIndex(index);
+        if (windowSamples < 1 || windowSamples > getMaxWindowSamples()) {
+            throw std::out_of_range("Window size in samples is zero or larger than configured maximum at construction.");
         }
-        entry_[checkWindowIndex(index)].setWindowSamplesAndScale(windowSamples, scale);
+        windows_.setWindowSamplesAndScale(i, windowSamples, scale);
         optimiseForMaximumSamples();
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     void TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setAverages(
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::setAverages(
             S average)
     {
         for (size_t i = 0; i < entries_; i++) {
-            entry_[i].setAverage(average);
-        }
-        for (size_t i = 0; i < history_.historySize(); i++) {
-            history_.set(i, average);
+            windows_.setAverage(i, average);
         }
+        history_.fillWithAverage(average);
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     S TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getAverage(
+                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::getAverage(
             size_t index) const
     {
-        return entry_[checkWindowIndex(index)].getAverage();
+        return windows_.getAverage(checkWindowIndex(index));
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     size_t TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                     MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getWindowSize(
+                                                     MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::getWindowSize(
             size_t index) const
     {
-        return entry_[checkWindowIndex(index)].windowSamples();
+        return windows_.windowSamples(checkWindowIndex(index));
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     S TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getWindowScale(
+                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::getWindowScale(
             size_t index) const
     {
-        checkWindowIndex(index);
-        return entry_[index].scale();
+        return windows_.scale(checkWindowIndex(index));
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     void TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::addInput(
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::addInput(
             S input)
     {
-        for (size_t i = 0; i < getUsedWindows(); i++) {
-            entry_[i].addInput(input);
-        }
+        windows_.addInput(input, usedWindows_);
         history_.write(input);
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
     S TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO>::addInputGetMax(
+                                                MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::addInputGetMax(
             const S input, S minimumValue)
     {
-        S average = minimumValue;
-        for (size_t i = 0; i < getUsedWindows(); i++) {
-            Window &entry = entry_[i];
-            entry.addInput(input);
-            const S v1 = entry.getAverage();
-            average = std::max(v1, average);
-        }
+        S average = windows_.addInputGetMax(input, minimumValue, usedWindows_);
         history_.write(input);
         return average;
     }
 
     template<
-            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
-    TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
-                                              MIN_ERROR_DECAY_TO_WINDOW_RATIO>::~TrueFloatingPointWeightedMovingAverageSet()
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
+    void TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::prepareWindowSizeAndScale(
+            size_t index, size_t windowSamples, S scale)
     {
-        delete[] entry_;
+        if (index >= draft_.usedWindows) {
+            throw std::out_of_range("Window index greater than prepared windows to use");
+        }
+        if (windowSamples < 1 || windowSamples > getMaxWindowSamples()) {
+            throw std::out_of_range("Window size in samples is zero or larger than configured maximum at construction.");
+        }
+        draft_.windowSamples[index] = windowSamples;
+        draft_.scale[index] =
+                helper::ScaledWindowForTrueFloatingPointMovingAverage<S, POWER2_HISTORY>::limitedScale(scale);
+        history_.getWindowFactors(windowSamples, draft_.inputFactor[index], draft_.historyFactor[index]);
     }
 
+    template<
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
+    void TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::prepareUsedWindows(
+            size_t windows)
+    {
+        if (windows > 0 && windows <= getMaxWindows()) {
+            draft_.usedWindows = windows;
+        }
+        else {
+            throw std::out_of_range(
+                    "Number of used windows zero or larger than condigured maximum at construction");
+        }
+    }
+
+    template<
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
+    void TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::publishParameters()
+    {
+        parameters_.writeSlot() = draft_;
+        parameters_.publish();
+    }
+
+    template<
+            typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_HISTORY>
+    bool TrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS,
+                                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO, POWER2_HISTORY>::adoptParameters()
+    {
+        if (!parameters_.consume()) {
+            return false;
+        }
+        const Parameters &parameters = parameters_.readSlot();
+        usedWindows_ = parameters.usedWindows;
+        for (size_t i = 0; i < usedWindows_; i++) {
+            windows_.setWindow(
+                    i, parameters.windowSamples[i], parameters.scale[i],
+                    parameters.inputFactor[i], parameters.historyFactor[i]);
+        }
+        if (!optimiseForMaximumSamples()) {
+            for (size_t i = 0; i < usedWindows_; i++) {
+                windows_.setReadPtr(i);
+            }
+        }
+        return true;
+    }
+
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    size_t LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::validMaxTimeConstants(size_t constants)
+    {
+        if (is_between(constants, MINIMUM_TIME_CONSTANTS, MAXIMUM_TIME_CONSTANTS)) {
+            return constants;
+        }
+        throw std::invalid_argument(TIME_CONSTANT_MESSAGE);
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    size_t LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::checkWindowIndex(size_t index) const
+    {
+        if (index < getUsedWindows()) {
+            return index;
+        }
+        throw std::out_of_range("Window index greater than configured windows to use");
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    LazyTrueFloatingPointWeightedMovingAverageSet<S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::
+    LazyTrueFloatingPointWeightedMovingAverageSet(
+            size_t maxWindowSamples, size_t errorMitigatingTimeConstant,
+            size_t maxTimeConstants, S average) :
+            entries_(validMaxTimeConstants(maxTimeConstants)),
+            usedWindows_(entries_),
+            history_(maxWindowSamples, errorMitigatingTimeConstant),
+            minimumWindowSamples_(validMinimumWindowSamples(errorMitigatingTimeConstant, maxWindowSamples))
+    {
+        setAverages(average);
+        for (size_t i = 0; i < entries_; i++) {
+            setWindowSizeAndScale(i, std::max(minimumWindowSamples_, (i + 1) * maxWindowSamples / entries_), 1.0);
+        }
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    size_t LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::validMinimumWindowSamples(
+            size_t emdSamples, size_t maxWindowSamples)
+    {
+        // The relative error is about epsilon * emdSamples *
+        // (DIFFERENCE_ERROR / windowSamples + DECAY_ERROR), which must not
+        // exceed 2^-SNR_BITS.
+        const double allowed =
+                1.0 / (static_cast<double>(static_cast<size_t>(1) << SNR_BITS) *
+                       std::numeric_limits<S>::epsilon()) -
+                DECAY_ERROR * emdSamples;
+        if (allowed > 0) {
+            const double minimum = ceil(DIFFERENCE_ERROR * emdSamples / allowed);
+            if (minimum <= maxWindowSamples) {
+                return std::max(static_cast<size_t>(1), static_cast<size_t>(minimum));
+            }
+        }
+        throw std::invalid_argument(
+                "LazyTrueFloatingPointWeightedMovingAverageSet: error mitigating decay too long for SNR_BITS of precision with this sample type and window size.");
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setUsedWindows(size_t windows)
+    {
+        if (windows > 0 && windows <= getMaxWindows()) {
+            usedWindows_ = windows;
+        }
+        else {
+            throw std::out_of_range(
+                    "Number of used windows zero or larger than condigured maximum at construction");
+        }
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setWindowSizeAndScale(
+            size_t index, size_t windowSamples, S scale)
+    {
+        if (!is_between(windowSamples, minimumWindowSamples_, getMaxWindowSamples())) {
+            throw std::out_of_range("Window size in samples is smaller than the minimum for precision or larger than configured maximum at construction.");
+        }
+        const size_t i = checkWindowIndex(index);
+        windowSamples_[i] = windowSamples;
+        scale_[i] = helper::ScaledWindowForTrueFloatingPointMovingAverage<S>::limitedScale(scale);
+        history_.getWindowFactors(windowSamples, inputFactor_[i], historyFactor_[i]);
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setAverages(S average)
+    {
+        // The decayed sum of an infinite history of average
+        decayedSum_ = average / (1.0 - history_.emdFactor());
+        history_.fillWithAverage(decayedSum_);
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    S LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getAverage(size_t index) const
+    {
+        const size_t i = checkWindowIndex(index);
+        return scale_[i] * getUnscaledAverage(i);
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    size_t LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getWindowSize(size_t index) const
+    {
+        return windowSamples_[checkWindowIndex(index)];
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    S LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getWindowScale(size_t index) const
+    {
+        return scale_[checkWindowIndex(index)];
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::addInput(S input)
+    {
+        history_.write(decayedSum_);
+        decayedSum_ = history_.emdFactor() * decayedSum_ + input;
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::addInputs(
+            const S *input, size_t samples)
+    {
+        const S emdFactor = history_.emdFactor();
+        S decayedSum = decayedSum_;
+        while (samples > 0) {
+            const size_t block = std::min(
+                    samples, history_.samplesBeforeWrap(history_.writePtr()));
+            S *write = history_.writeBlock(block);
+            for (size_t i = 0; i < block; i++) {
+                *(write - i) = decayedSum;
+                decayedSum = emdFactor * decayedSum + input[i];
+            }
+            input += block;
+            samples -= block;
+        }
+        decayedSum_ = decayedSum;
+    }
+
+    template<typename S, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    S LazyTrueFloatingPointWeightedMovingAverageSet<
+            S, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getMaximum(S minimumValue) const
+    {
+        S result = minimumValue;
+        for (size_t i = 0; i < usedWindows_; i++) {
+            const S scaled = scale_[i] * getUnscaledAverage(i);
+            result = scaled > result ? scaled : result;
+        }
+        return result;
+    }
+
+    template<typename S, size_t DECIMATION, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    MultiRateMovingAverageSet<S, DECIMATION, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::MultiRateMovingAverageSet(
+            size_t maxShortWindowSamples, size_t maxLongWindowSamples,
+            size_t errorMitigatingTimeConstant,
+            size_t shortWindows, size_t longWindows, S average) :
+            fullRate_(maxShortWindowSamples, errorMitigatingTimeConstant, shortWindows, average),
+            decimated_((maxLongWindowSamples + DECIMATION - 1) / DECIMATION,
+                       errorMitigatingTimeConstant / DECIMATION, longWindows, average)
+    {
+        setAverages(average);
+    }
+
+    template<typename S, size_t DECIMATION, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void MultiRateMovingAverageSet<S, DECIMATION, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setWindowSizeAndScale(
+            size_t index, size_t windowSamples, S scale)
+    {
+        if (index < getShortWindows()) {
+            fullRate_.setWindowSizeAndScale(index, windowSamples, scale);
+            return;
+        }
+        const size_t blocks = std::max(size_t(1), (windowSamples + DECIMATION / 2) / DECIMATION);
+        decimated_.setWindowSizeAndScale(index - getShortWindows(), blocks, scale);
+    }
+
+    template<typename S, size_t DECIMATION, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    size_t MultiRateMovingAverageSet<S, DECIMATION, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getWindowSize(
+            size_t index) const
+    {
+        return index < getShortWindows()
+               ? fullRate_.getWindowSize(index)
+               : DECIMATION * decimated_.getWindowSize(index - getShortWindows());
+    }
+
+    template<typename S, size_t DECIMATION, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    S MultiRateMovingAverageSet<S, DECIMATION, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getWindowScale(
+            size_t index) const
+    {
+        return index < getShortWindows()
+               ? fullRate_.getWindowScale(index)
+               : decimated_.getWindowScale(index - getShortWindows());
+    }
+
+    template<typename S, size_t DECIMATION, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    S MultiRateMovingAverageSet<S, DECIMATION, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getAverage(
+            size_t index) const
+    {
+        return index < getShortWindows()
+               ? fullRate_.getAverage(index)
+               : decimated_.getAverage(index - getShortWindows());
+    }
+
+    template<typename S, size_t DECIMATION, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    S MultiRateMovingAverageSet<S, DECIMATION, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::getDecimatedMaximum() const
+    {
+        S result = decimated_.getAverage(0);
+        for (size_t i = 1; i < decimated_.getUsedWindows(); i++) {
+            result = std::max(result, decimated_.getAverage(i));
+        }
+        return result;
+    }
+
+    template<typename S, size_t DECIMATION, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void MultiRateMovingAverageSet<S, DECIMATION, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setAverages(
+            S average)
+    {
+        fullRate_.setAverages(average);
+        decimated_.setAverages(average);
+        blockSum_ = 0;
+        blockSamples_ = 0;
+        longTarget_ = getDecimatedMaximum();
+        longMaximum_ = longTarget_;
+        longStep_ = 0;
+    }
+
+    template<typename S, size_t DECIMATION, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    S MultiRateMovingAverageSet<S, DECIMATION, SNR_BITS, MIN_ERROR_DECAY_TO_WINDOW_RATIO>::addInputGetMax(
+            S input, S minimumValue)
+    {
+        blockSum_ += input;
+        if (++blockSamples_ == DECIMATION) {
+            // Glide from the previous block maximum to the new one
+            longMaximum_ = longTarget_;
+            longTarget_ = decimated_.addInputGetMax(
+                    blockSum_ * (S(1) / DECIMATION), std::numeric_limits<S>::lowest());
+            longStep_ = (longTarget_ - longMaximum_) * (S(1) / DECIMATION);
+            blockSum_ = 0;
+            blockSamples_ = 0;
+        }
+        else {
+            longMaximum_ += longStep_;
+        }
+        return std::max(longMaximum_, fullRate_.addInputGetMax(input, minimumValue));
+    }
+
+    template<
+            typename S, size_t CHANNELS, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    size_t MultiChannelMovingAverage<S, CHANNELS, SNR_BITS,
+                                     MIN_ERROR_DECAY_TO_WINDOW_RATIO>::validHistoryFrames(
+            size_t frames, size_t emdSamples)
+    {
+        if (Metrics::validWindowSizeInSamples(frames) < Metrics::validErrorMitigatingDecaySamples(emdSamples) / Metrics::MIN_MIN_ERROR_DECAY_TO_WINDOW_RATIO) {
+            return frames;
+        }
+        throw std::invalid_argument("Invalid combination of window size and ratio between that and error mitigating decay samples.");
+    }
+
+    template<
+            typename S, size_t CHANNELS, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    MultiChannelMovingAverage<S, CHANNELS, SNR_BITS,
+                              MIN_ERROR_DECAY_TO_WINDOW_RATIO>::MultiChannelMovingAverage(
+            const size_t maxWindowSize, const size_t emdSamples)
+            :
+            historyFrames_(validHistoryFrames(maxWindowSize, emdSamples)),
+            history_(historyFrames_ * CHANNELS),
+            emdSamples_(emdSamples),
+            emdFactor_(exp(-1.0 / emdSamples)),
+            historyEndPtr_(historyFrames_ - 1)
+    {
+        setAverage(0);
+        setWindowSize(maxWindowSize);
+    }
+
+    template<
+            typename S, size_t CHANNELS, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void MultiChannelMovingAverage<S, CHANNELS, SNR_BITS,
+                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setAverage(
+            const S average)
+    {
+        history_.fill(average);
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            average_[channel] = average;
+        }
+    }
+
+    template<
+            typename S, size_t CHANNELS, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void MultiChannelMovingAverage<S, CHANNELS, SNR_BITS,
+                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::setWindowSize(
+            const size_t windowSamples)
+    {
+        if (!is_between(windowSamples, 1, historyFrames_)) {
+            throw std::invalid_argument("MultiChannelMovingAverage: window samples must lie between 1 and maximum window size");
+        }
+        windowSamples_ = windowSamples;
+        helper::getWindowFactorsForEmd(
+                emdFactor_, emdSamples_, windowSamples_, inputFactor_, historyFactor_);
+        // Older frames that the active history did not keep are not known,
+        // so they are assumed to be equal to the current averages
+        const size_t newSize = force_between(windowSamples_, 4, historyFrames_);
+        writePtr_ = helper::resizeHistoryKeepingAge(
+                history_.data(), CHANNELS, writePtr_, historyEndPtr_ + 1, newSize, average_);
+        historyEndPtr_ = newSize - 1;
+        readPtr_ = (writePtr_ + windowSamples_) % (historyEndPtr_ + 1);
+    }
+
+    template<
+            typename S, size_t CHANNELS, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void MultiChannelMovingAverage<S, CHANNELS, SNR_BITS,
+                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::addFramesUnwrapped(
+            const S *input, S *output, size_t frames)
+    {
+        const S *read = history_.data() + readPtr_ * CHANNELS;
+        S *write = history_.data() + writePtr_ * CHANNELS;
+        const S emdFactor = emdFactor_;
+        const S inputFactor = inputFactor_;
+        const S historyFactor = historyFactor_;
+        // A local copy of the averages cannot alias input, output or history
+        alignas(ALIGN) S average[CHANNELS];
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            average[channel] = average_[channel];
+        }
+        for (size_t frame = 0; frame < frames; frame++) {
+            const size_t offset = frame * CHANNELS;
+            const S *in = input + offset;
+            S *out = output + offset;
+            const S *history = read - offset;
+            S *destination = write - offset;
+            for (size_t channel = 0; channel < CHANNELS; channel++) {
+                const S value = in[channel];
+                average[channel] =
+                        emdFactor * average[channel] +
+                        inputFactor * value -
+                        historyFactor * history[channel];
+                destination[channel] = value;
+                out[channel] = average[channel];
+            }
+        }
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            average_[channel] = average[channel];
+        }
+        readPtr_ = readPtr_ >= frames ? readPtr_ - frames : historyEndPtr_;
+        writePtr_ = writePtr_ >= frames ? writePtr_ - frames : historyEndPtr_;
+    }
+
+    template<
+            typename S, size_t CHANNELS, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO>
+    void MultiChannelMovingAverage<S, CHANNELS, SNR_BITS,
+                                   MIN_ERROR_DECAY_TO_WINDOW_RATIO>::addFrames(
+            const S *input, S *output, size_t frames)
+    {
+        while (frames > 0) {
+            const size_t block = std::min(
+                    frames, std::min(readPtr_, writePtr_) + 1);
+            addFramesUnwrapped(input, output, block);
+            input += block * CHANNELS;
+            output += block * CHANNELS;
+            frames -= block;
+        }
+    }
+
+    template<typename S, size_t CHANNELS, size_t SNR_BITS>
+    CompensatedMultiChannelMovingAverage<S, CHANNELS, SNR_BITS>::CompensatedMultiChannelMovingAverage(
+            const size_t maxWindowSize)
+            :
+            historyFrames_(helper::validHistorySize(
+                    maxWindowSize, MAX_WINDOW_SAMPLES,
+                    "CompensatedMultiChannelMovingAverage: window size must lie between 1 and MAX_WINDOW_SAMPLES.")),
+            history_(historyFrames_ * CHANNELS)
+    {
+        setAverage(0);
+        setWindowSize(maxWindowSize);
+    }
+
+    template<typename S, size_t CHANNELS, size_t SNR_BITS>
+    void CompensatedMultiChannelMovingAverage<S, CHANNELS, SNR_BITS>::setAverage(
+            const S average)
+    {
+        history_.fill(average);
+        resynchronise();
+    }
+
+    template<typename S, size_t CHANNELS, size_t SNR_BITS>
+    void CompensatedMultiChannelMovingAverage<S, CHANNELS, SNR_BITS>::setWindowSize(
+            const size_t windowSamples)
+    {
+        if (!is_between(windowSamples, 1, historyFrames_)) {
+            throw std::invalid_argument("CompensatedMultiChannelMovingAverage: window samples must lie between 1 and maximum window size");
+        }
+        windowSamples_ = windowSamples;
+        windowScale_ = 1.0 / windowSamples_;
+        readPtr_ = (writePtr_ + windowSamples_) % historyFrames_;
+        resynchronise();
+    }
+
+    template<typename S, size_t CHANNELS, size_t SNR_BITS>
+    void CompensatedMultiChannelMovingAverage<S, CHANNELS, SNR_BITS>::resynchronise()
+    {
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            sum_[channel] = 0;
+            compensation_[channel] = 0;
+        }
+        helper::forEachWindowFrame(
+                history_.data(), CHANNELS, historyFrames_, writePtr_, windowSamples_,
+                [this](const S *frame) {
+                    for (size_t channel = 0; channel < CHANNELS; channel++) {
+                        compensation_[channel] += helper::addGetError(sum_[channel], frame[channel]);
+                    }
+                });
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            compensation_[channel] = helper::addGetError(sum_[channel], compensation_[channel]);
+        }
+    }
+
+    template<typename S, size_t CHANNELS, size_t SNR_BITS>
+    void CompensatedMultiChannelMovingAverage<S, CHANNELS, SNR_BITS>::addFramesUnwrapped(
+            const S *input, S *output, size_t frames)
+    {
+        const S *read = history_.data() + readPtr_ * CHANNELS;
+        S *write = history_.data() + writePtr_ * CHANNELS;
+        const S windowScale = windowScale_;
+        // Local copies of the sums cannot alias input, output or history
+        alignas(ALIGN) S sum[CHANNELS];
+        alignas(ALIGN) S compensation[CHANNELS];
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            sum[channel] = sum_[channel];
+            compensation[channel] = compensation_[channel];
+        }
+        for (size_t frame = 0; frame < frames; frame++) {
+            const size_t offset = frame * CHANNELS;
+            const S *in = input + offset;
+            S *out = output + offset;
+            const S *history = read - offset;
+            S *destination = write - offset;
+            // Separate loops for the sums and the stores let all channels
+            // be updated in vector lanes
+            for (size_t channel = 0; channel < CHANNELS; channel++) {
+                S delta = in[channel];
+                const S deltaError = helper::addGetError(delta, -history[channel]);
+                const S sumError = helper::addGetError(sum[channel], delta);
+                compensation[channel] += deltaError + sumError;
+            }
+            for (size_t channel = 0; channel < CHANNELS; channel++) {
+                destination[channel] = in[channel];
+                out[channel] = (sum[channel] + compensation[channel]) * windowScale;
+            }
+        }
+        // Fold the compensation into the sum, so it does not grow
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            S total = sum[channel];
+            compensation_[channel] = helper::addGetError(total, compensation[channel]);
+            sum_[channel] = total;
+        }
+        readPtr_ = readPtr_ >= frames ? readPtr_ - frames : historyFrames_ - 1;
+        writePtr_ = writePtr_ >= frames ? writePtr_ - frames : historyFrames_ - 1;
+    }
+
+    template<typename S, size_t CHANNELS, size_t SNR_BITS>
+    void CompensatedMultiChannelMovingAverage<S, CHANNELS, SNR_BITS>::addFrames(
+            const S *input, S *output, size_t frames)
+    {
+        while (frames > 0) {
+            const size_t block = std::min(
+                    frames, std::min(readPtr_, writePtr_) + 1);
+            addFramesUnwrapped(input, output, block);
+            input += block * CHANNELS;
+            output += block * CHANNELS;
+            frames -= block;
+        }
+    }
+
+    template<typename S, typename A>
+    PreciseWindowAverage<S, A>::PreciseWindowAverage(const size_t maxWindowSize)
+            :
+            historySamples_(helper::validHistorySize(
+                    maxWindowSize, MAX_WINDOW_SAMPLES,
+                    "PreciseWindowAverage: window size must lie between 1 and MAX_WINDOW_SAMPLES.")),
+            history_(historySamples_)
+    {
+        setAverage(0);
+        setWindowSize(maxWindowSize);
+    }
+
+    template<typename S, typename A>
+    void PreciseWindowAverage<S, A>::setAverage(const S average)
+    {
+        history_.fill(average);
+        sum_ = static_cast<A>(average) * static_cast<A>(windowSamples_);
+    }
+
+    template<typename S, typename A>
+    void PreciseWindowAverage<S, A>::setWindowSize(const size_t windowSamples)
+    {
+        if (!is_between(windowSamples, 1, historySamples_)) {
+            throw std::invalid_argument("PreciseWindowAverage: window samples must lie between 1 and maximum window size");
+        }
+        windowSamples_ = windowSamples;
+        windowScale_ = 1.0 / windowSamples_;
+        readPtr_ = (writePtr_ + windowSamples_) % historySamples_;
+        sum_ = helper::windowSum<A>(
+                history_.data(), historySamples_, writePtr_, windowSamples_);
+    }
+
+    template<typename S, typename A>
+    size_t PreciseWindowAverageSet<S, A>::validMaxTimeConstants(size_t constants)
+    {
+        if (is_between(constants, MINIMUM_TIME_CONSTANTS, MAXIMUM_TIME_CONSTANTS)) {
+            return constants;
+        }
+        throw std::invalid_argument(TIME_CONSTANT_MESSAGE);
+    }
+
+    template<typename S, typename A>
+    size_t PreciseWindowAverageSet<S, A>::checkWindowIndex(size_t index) const
+    {
+        if (index < getUsedWindows()) {
+            return index;
+        }
+        throw std::out_of_range("Window index greater than configured windows to use");
+    }
+
+    template<typename S, typename A>
+    PreciseWindowAverageSet<S, A>::PreciseWindowAverageSet(
+            size_t maxWindowSamples, size_t maxTimeConstants, S average) :
+            entries_(validMaxTimeConstants(maxTimeConstants)),
+            usedWindows_(entries_),
+            historySamples_(helper::validHistorySize(
+                    maxWindowSamples, MAX_WINDOW_SAMPLES,
+                    "PreciseWindowAverageSet: window size must lie between 1 and MAX_WINDOW_SAMPLES.")),
+            history_(2 * historySamples_)
+    {
+        for (size_t i = 0; i < MAXIMUM_TIME_CONSTANTS; i++) {
+            sum_[i] = 0;
+            readOffset_[i] = 0;
+            factor_[i] = 0;
+            windowSamples_[i] = 1;
+            scale_[i] = 1;
+        }
+        setAverages(average);
+        for (size_t i = 0; i < entries_; i++) {
+            setWindowSizeAndScale(i, std::max(static_cast<size_t>(1), (i + 1) * maxWindowSamples / entries_), 1.0);
+        }
+    }
+
+    template<typename S, typename A>
+    double PreciseWindowAverageSet<S, A>::toDouble(A sum)
+    {
+        if constexpr (sizeof(A) == sizeof(double)) {
+            // Adding the sum to the bits of 1.5 * 2^52 yields the bits of
+            // 1.5 * 2^52 + sum, as long as the magnitude of the sum is below
+            // 2^51. Subtracting 1.5 * 2^52 again is exact.
+            static constexpr double MAGIC = 6755399441055744.0;
+            static constexpr int64_t MAGIC_BITS = 0x4338000000000000;
+            const int64_t bits = MAGIC_BITS + static_cast<int64_t>(sum);
+            double result;
+            std::memcpy(&result, &bits, sizeof(double));
+            return result - MAGIC;
+        }
+        else {
+            return static_cast<double>(sum);
+        }
+    }
+
+    template<typename S, typename A>
+    void PreciseWindowAverageSet<S, A>::write(S input)
+    {
+        history_[writePtr_] = input;
+        history_[writePtr_ + historySamples_] = input;
+        writePtr_ = writePtr_ > 0 ? writePtr_ - 1 : historySamples_ - 1;
+    }
+
+    template<typename S, typename A>
+    void PreciseWindowAverageSet<S, A>::synchronise(size_t index)
+    {
+        readOffset_[index] = windowSamples_[index];
+        sum_[index] = helper::windowSum<A>(
+                history_.data(), historySamples_, writePtr_, windowSamples_[index]);
+    }
+
+    template<typename S, typename A>
+    void PreciseWindowAverageSet<S, A>::setUsedWindows(size_t windows)
+    {
+        if (windows > 0 && windows <= getMaxWindows()) {
+            for (size_t i = usedWindows_; i < windows; i++) {
+                synchronise(i);
+            }
+            usedWindows_ = windows;
+        }
+        else {
+            throw std::out_of_range(
+                    "Number of used windows zero or larger than condigured maximum at construction");
+        }
+    }
+
+    template<typename S, typename A>
+    void PreciseWindowAverageSet<S, A>::setWindowSizeAndScale(
+            size_t index, size_t windowSamples, double scale)
+    {
+        if (!is_between(windowSamples, 1, historySamples_)) {
+            throw std::out_of_range("Window size in samples is zero or larger than configured maximum at construction.");
+        }
+        const size_t i = checkWindowIndex(index);
+        windowSamples_[i] = windowSamples;
+        scale_[i] = scale;
+        factor_[i] = scale / windowSamples;
+        synchronise(i);
+    }
+
+    template<typename S, typename A>
+    void PreciseWindowAverageSet<S, A>::setAverages(S average)
+    {
+        history_.fill(average);
+        for (size_t i = 0; i < entries_; i++) {
+            sum_[i] = static_cast<A>(average) * static_cast<A>(windowSamples_[i]);
+        }
+    }
+
+    template<typename S, typename A>
+    double PreciseWindowAverageSet<S, A>::getAverage(size_t index) const
+    {
+        const size_t i = checkWindowIndex(index);
+        return factor_[i] * sum_[i];
+    }
+
+    template<typename S, typename A>
+    A PreciseWindowAverageSet<S, A>::getSum(size_t index) const
+    {
+        return sum_[checkWindowIndex(index)];
+    }
+
+    template<typename S, typename A>
+    size_t PreciseWindowAverageSet<S, A>::getWindowSize(size_t index) const
+    {
+        return windowSamples_[checkWindowIndex(index)];
+    }
+
+    template<typename S, typename A>
+    double PreciseWindowAverageSet<S, A>::getWindowScale(size_t index) const
+    {
+        return scale_[checkWindowIndex(index)];
+    }
+
+    template<typename S, typename A>
+    void PreciseWindowAverageSet<S, A>::addInput(S input) TDAP_RESTRICT_THIS
+    {
+        const A value = input;
+        const size_t windows = usedWindows_;
+        const S * const history = history_.data() + writePtr_;
+        for (size_t i = 0; i < windows; i++) {
+            sum_[i] += value - history[readOffset_[i]];
+        }
+        write(input);
+    }
+
+    template<typename S, typename A>
+    double PreciseWindowAverageSet<S, A>::addInputGetMax(S input, double minimumValue) TDAP_RESTRICT_THIS
+    {
+        const A value = input;
+        const size_t windows = usedWindows_;
+        const S * const history = history_.data() + writePtr_;
+        // The maximum is taken per vector lane: each window is compared with
+        // the window one vector before it, so that the loop is vectorized
+        // without fast-math.
+        alignas(ALIGN) double maximum[MAXIMUM_TIME_CONSTANTS + LANES];
+        for (size_t lane = 0; lane < LANES; lane++) {
+            maximum[lane] = minimumValue;
+        }
+        for (size_t i = 0; i < windows; i++) {
+            const A sum = sum_[i] + value - history[readOffset_[i]];
+            sum_[i] = sum;
+            const double scaled = factor_[i] * toDouble(sum);
+            maximum[i + LANES] = scaled > maximum[i] ? scaled : maximum[i];
+        }
+        write(input);
+        // Lanes before LANES still hold the minimum value
+        const size_t lanes = windows < LANES ? windows : LANES;
+        const double * const laneMaximum = maximum + windows + LANES - lanes;
+        double result = minimumValue;
+        for (size_t lane = 0; lane < lanes; lane++) {
+            result = laneMaximum[lane] > result ? laneMaximum[lane] : result;
+        }
+        return result;
+    }
+
+    template<typename S, size_t SNR_BITS>
+    ResynchronisingMovingAverage<S, SNR_BITS>::ResynchronisingMovingAverage(
+            const size_t maxWindowSize)
+            :
+            historySamples_(helper::validHistorySize(
+                    maxWindowSize, MAX_WINDOW_SAMPLES,
+                    "ResynchronisingMovingAverage: window size must lie between 1 and MAX_WINDOW_SAMPLES.")),
+            history_(historySamples_)
+    {
+        setAverage(0);
+        setWindowSize(maxWindowSize);
+    }
+
+    template<typename S, size_t SNR_BITS>
+    void ResynchronisingMovingAverage<S, SNR_BITS>::setAverage(const S average)
+    {
+        history_.fill(average);
+        sum_ = average * windowSamples_;
+        shadowSum_ = 0;
+        shadowSamples_ = 0;
+    }
+
+    template<typename S, size_t SNR_BITS>
+    void ResynchronisingMovingAverage<S, SNR_BITS>::setWindowSize(
+            const size_t windowSamples)
+    {
+        if (!is_between(windowSamples, 1, historySamples_)) {
+            throw std::invalid_argument("ResynchronisingMovingAverage: window samples must lie between 1 and maximum window size");
+        }
+        windowSamples_ = windowSamples;
+        windowScale_ = 1.0 / windowSamples_;
+        readPtr_ = (writePtr_ + windowSamples_) % historySamples_;
+        sum_ = helper::windowSum<S>(
+                history_.data(), historySamples_, writePtr_, windowSamples_);
+        shadowSum_ = 0;
+        shadowSamples_ = 0;
+    }
+
+    template<typename S, size_t SNR_BITS>
+    void ResynchronisingMovingAverage<S, SNR_BITS>::resynchroniseIfComplete()
+    {
+        if (shadowSamples_ == windowSamples_) {
+            sum_ = shadowSum_;
+            shadowSum_ = 0;
+            shadowSamples_ = 0;
+        }
+    }
+
+    template<typename S, size_t SNR_BITS>
+    void ResynchronisingMovingAverage<S, SNR_BITS>::addInput(const S input)
+    {
+        sum_ += input - history_[readPtr_];
+        shadowSum_ += input;
+        shadowSamples_++;
+        history_[writePtr_] = input;
+        readPtr_ = readPtr_ > 0 ? readPtr_ - 1 : historySamples_ - 1;
+        writePtr_ = writePtr_ > 0 ? writePtr_ - 1 : historySamples_ - 1;
+        resynchroniseIfComplete();
+    }
+
+    template<typename S, size_t SNR_BITS>
+    void ResynchronisingMovingAverage<S, SNR_BITS>::addInputs(
+            const S *input, S *output, size_t samples)
+    {
+        while (samples > 0) {
+            const size_t block = std::min(
+                    std::min(samples, windowSamples_ - shadowSamples_),
+                    std::min(readPtr_, writePtr_) + 1);
+            const S *read = history_.data() + readPtr_;
+            S *write = history_.data() + writePtr_;
+            const S windowScale = windowScale_;
+            S sum = sum_;
+            S shadowSum = shadowSum_;
+            for (size_t i = 0; i < block; i++) {
+                const S value = input[i];
+                sum += value - *(read - i);
+                shadowSum += value;
+                *(write - i) = value;
+                output[i] = windowScale * sum;
+            }
+            sum_ = sum;
+            shadowSum_ = shadowSum;
+            shadowSamples_ += block;
+            readPtr_ = readPtr_ >= block ? readPtr_ - block : historySamples_ - 1;
+            writePtr_ = writePtr_ >= block ? writePtr_ - block : historySamples_ - 1;
+            resynchroniseIfComplete();
+            if (shadowSamples_ == 0) {
+                // The last output of the block uses the re-synchronised sum
+                output[block - 1] = windowScale * sum_;
+            }
+            input += block;
+            output += block;
+            samples -= block;
+        }
+    }
+
+    template<typename S>
+    size_t WindowSumTree<S>::validHistorySamples(size_t samples)
+    {
+        if (is_between(samples, 1, std::numeric_limits<size_t>::max() / 4)) {
+            return samples;
+        }
+        throw std::invalid_argument("WindowSumTree: window size must be positive and not too big.");
+    }
+
+    template<typename S>
+    size_t WindowSumTree<S>::levelsFor(size_t samples)
+    {
+        // Level k contains blocks of 2^k samples and the biggest block must
+        // not be bigger than the history.
+        size_t levels = 1;
+        while ((static_cast<size_t>(1) << levels) <= samples) {
+            levels++;
+        }
+        return levels;
+    }
+
+    template<typename S>
+    size_t WindowSumTree<S>::totalBlocks()
+    {
+        size_t total = 0;
+        for (size_t level = 0; level < levels_; level++) {
+            // Enough blocks to cover the history, plus partly covered blocks
+            // at both ends
+            const size_t blocks = Power2::next((historySamples_ >> level) + 2);
+            offset_[level] = total;
+            mask_[level] = blocks - 1;
+            total += blocks;
+        }
+        return total;
+    }
+
+    template<typename S>
+    WindowSumTree<S>::WindowSumTree(const size_t maxWindowSize)
+            :
+            historySamples_(validHistorySamples(maxWindowSize)),
+            levels_(levelsFor(historySamples_)),
+            blocks_(totalBlocks())
+    {
+        setAverage(0);
+    }
+
+    template<typename S>
+    void WindowSumTree<S>::setAverage(const S average)
+    {
+        for (size_t level = 0; level < levels_; level++) {
+            const S sum = average * static_cast<S>(static_cast<size_t>(1) << level);
+            for (size_t i = 0; i <= mask_[level]; i++) {
+                blocks_[offset_[level] + i] = sum;
+            }
+        }
+        // All blocks in the history are complete, so that queries of windows
+        // up to the maximum only use blocks with the average.
+        next_ = Power2::next(historySamples_);
+    }
+
+    template<typename S>
+    void WindowSumTree<S>::addInput(const S input)
+    {
+        size_t index = next_++;
+        S sum = input;
+        block(0, index) = sum;
+        // Each odd block completes the block of twice the size on the next
+        // level, together with the even block before it.
+        for (size_t level = 1; level < levels_ && (index & 1) != 0; level++) {
+            sum = block(level - 1, index - 1) + sum;
+            index >>= 1;
+            block(level, index) = sum;
+        }
+    }
+
+    template<typename S>
+    void WindowSumTree<S>::addInputs(const S *input, size_t samples)
+    {
+        for (size_t i = 0; i < samples; i++) {
+            addInput(input[i]);
+        }
+    }
+
+    template<typename S>
+    S WindowSumTree<S>::getSum(size_t windowSamples) const
+    {
+        if (!is_between(windowSamples, 1, historySamples_)) {
+            throw std::invalid_argument("WindowSumTree: window samples must lie between 1 and maximum window size");
+        }
+        // Covers samples [start, end) with the biggest aligned blocks,
+        // working inwards from both ends, like a bottom-up segment tree.
+        size_t start = next_ - windowSamples;
+        size_t end = next_;
+        S sum = 0;
+        for (size_t level = 0; start < end; level++) {
+            if ((start & 1) != 0) {
+                sum += block(level, start);
+                start++;
+            }
+            if ((end & 1) != 0) {
+                end--;
+                sum += block(level, end);
+            }
+            start >>= 1;
+            end >>= 1;
+        }
+        return sum;
+    }
+
+    template<
+            typename S, size_t MAX_SAMPLES, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_CAPACITY>
+    size_t FixedCapacityTrueFloatingPointWeightedMovingAverage<S, MAX_SAMPLES, SNR_BITS,
+                                                               MIN_ERROR_DECAY_TO_WINDOW_RATIO,
+                                                               POWER2_CAPACITY>::validEmdSamples(
+            size_t emdSamples)
+    {
+        if (MAX_SAMPLES < Metrics::validErrorMitigatingDecaySamples(emdSamples) / Metrics::MIN_MIN_ERROR_DECAY_TO_WINDOW_RATIO) {
+            return emdSamples;
+        }
+        throw std::invalid_argument("Invalid combination of window size and ratio between that and error mitigating decay samples.");
+    }
+
+    template<
+            typename S, size_t MAX_SAMPLES, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_CAPACITY>
+    FixedCapacityTrueFloatingPointWeightedMovingAverage<S, MAX_SAMPLES, SNR_BITS,
+                                                        MIN_ERROR_DECAY_TO_WINDOW_RATIO,
+                                                        POWER2_CAPACITY>::FixedCapacityTrueFloatingPointWeightedMovingAverage(
+            const size_t emdSamples)
+            :
+            emdSamples_(validEmdSamples(emdSamples)),
+            emdFactor_(exp(-1.0 / emdSamples))
+    {
+        setAverage(0);
+        setWindowSize(MAX_SAMPLES);
+    }
+
+    template<
+            typename S, size_t MAX_SAMPLES, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_CAPACITY>
+    void FixedCapacityTrueFloatingPointWeightedMovingAverage<S, MAX_SAMPLES, SNR_BITS,
+                                                             MIN_ERROR_DECAY_TO_WINDOW_RATIO,
+                                                             POWER2_CAPACITY>::setAverage(
+            const S average)
+    {
+        history_.fillWithAverage(average);
+        average_ = average;
+    }
+
+    template<
+            typename S, size_t MAX_SAMPLES, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_CAPACITY>
+    void FixedCapacityTrueFloatingPointWeightedMovingAverage<S, MAX_SAMPLES, SNR_BITS,
+                                                             MIN_ERROR_DECAY_TO_WINDOW_RATIO,
+                                                             POWER2_CAPACITY>::setWindowSize(
+            const size_t windowSamples)
+    {
+        if (!is_between(windowSamples, 1, MAX_SAMPLES)) {
+            throw std::invalid_argument("FixedCapacityTrueFloatingPointWeightedMovingAverage: window samples must lie between 1 and MAX_SAMPLES");
+        }
+        windowSamples_ = windowSamples;
+        helper::getWindowFactorsForEmd(
+                emdFactor_, emdSamples_, windowSamples_, inputFactor_, historyFactor_);
+        readPtr_ = history_.getRelative(windowSamples_);
+    }
+
+    template<
+            typename S, size_t MAX_SAMPLES, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_CAPACITY>
+    void FixedCapacityTrueFloatingPointWeightedMovingAverage<S, MAX_SAMPLES, SNR_BITS,
+                                                             MIN_ERROR_DECAY_TO_WINDOW_RATIO,
+                                                             POWER2_CAPACITY>::addInput(
+            const S input)
+    {
+        average_ =
+                emdFactor_ * average_ +
+                inputFactor_ * input -
+                historyFactor_ * history_.getHistoryValue(readPtr_);
+        history_.write(input);
+    }
+
+    template<
+            typename S, size_t MAX_SAMPLES, size_t SNR_BITS, size_t MIN_ERROR_DECAY_TO_WINDOW_RATIO, bool POWER2_CAPACITY>
+    void FixedCapacityTrueFloatingPointWeightedMovingAverage<S, MAX_SAMPLES, SNR_BITS,
+                                                             MIN_ERROR_DECAY_TO_WINDOW_RATIO,
+                                                             POWER2_CAPACITY>::addInputs(
+            const S *input, S *output, size_t samples)
+    {
+        S average = average_;
+        while (samples > 0) {
+            const size_t block = std::min(samples, std::min(
+                    History::samplesBeforeWrap(readPtr_),
+                    History::samplesBeforeWrap(history_.writePtr())));
+            const S *read = history_.history() + readPtr_;
+            S *write = history_.writeBlock(block);
+            for (size_t i = 0; i < block; i++) {
+                const S value = input[i];
+                average =
+                        emdFactor_ * average +
+                        inputFactor_ * value -
+                        historyFactor_ * *(read - i);
+                *(write - i) = value;
+                output[i] = average;
+            }
+            History::skipHistoryValues(readPtr_, block);
+            input += block;
+            output += block;
+            samples -= block;
+        }
+        average_ = average;
+    }
 
 #endif //TDAP_AVERAGE_IMPL_HPP
@@ -0,0 +1,127 @@
+#ifndef TDAP_BIQUAD_IMPL_HPP
+#define TDAP_BIQUAD_IMPL_HPP
+/*
+ * tdap/biquad-impl.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace tdap::filter
+{
+    namespace helper
+    {
+        inline double validBiquadOmega(double sampleRate, double frequency)
+        {
+            if (sampleRate > 0 && frequency > 0 && frequency < sampleRate / 2) {
+                return 2.0 * M_PI * frequency / sampleRate;
+            }
+            throw std::invalid_argument("Biquad: frequency must lie between zero and half the sample rate");
+        }
+
+        inline double validBiquadAlpha(double omega, double q)
+        {
+            if (q > 0) {
+                return sin(omega) / (2.0 * q);
+            }
+            throw std::invalid_argument("Biquad: quality factor must be positive");
+        }
+    }
+
+    template<typename T>
+    void Biquad<T>::setCoefficients(T b0, T b1, T b2, T a1, T a2)
+    {
+        b0_ = b0;
+        b1_ = b1;
+        b2_ = b2;
+        a1_ = a1;
+        a2_ = a2;
+    }
+
+    template<typename T>
+    void Biquad<T>::filter(const T *input, T *output, size_t samples)
+    {
+        T z1 = z1_;
+        T z2 = z2_;
+        for (size_t i = 0; i < samples; i++) {
+            const T x = input[i];
+            const T y = b0_ * x + z1;
+            z1 = b1_ * x - a1_ * y + z2;
+            z2 = b2_ * x - a2_ * y;
+            output[i] = y;
+        }
+        z1_ = z1;
+        z2_ = z2;
+    }
+
+    template<typename T>
+    double Biquad<T>::getMaximumPoleRadius() const
+    {
+        const double discriminant = static_cast<double>(a1_) * a1_ - 4.0 * a2_;
+        if (discriminant < 0) {
+            // Complex conjugate poles with a product of a2
+            return sqrt(static_cast<double>(a2_));
+        }
+        const double root = sqrt(discriminant);
+        return std::max(fabs(-a1_ + root), fabs(-a1_ - root)) / 2;
+    }
+
+    template<typename T>
+    Biquad<T> Biquad<T>::lowPass(double sampleRate, double frequency, double q)
+    {
+        const double omega = helper::validBiquadOmega(sampleRate, frequency);
+        const double alpha = helper::validBiquadAlpha(omega, q);
+        const double cosine = cos(omega);
+        const double a0 = 1.0 + alpha;
+        const double b1 = (1.0 - cosine) / a0;
+        return Biquad(b1 / 2, b1, b1 / 2, -2.0 * cosine / a0, (1.0 - alpha) / a0);
+    }
+
+    template<typename T>
+    Biquad<T> Biquad<T>::highPass(double sampleRate, double frequency, double q)
+    {
+        const double omega = helper::validBiquadOmega(sampleRate, frequency);
+        const double alpha = helper::validBiquadAlpha(omega, q);
+        const double cosine = cos(omega);
+        const double a0 = 1.0 + alpha;
+        const double b1 = -(1.0 + cosine) / a0;
+        return Biquad(-b1 / 2, b1, -b1 / 2, -2.0 * cosine / a0, (1.0 - alpha) / a0);
+    }
+
+    template<typename T>
+    Biquad<T> Biquad<T>::peaking(double sampleRate, double frequency, double q, double gain)
+    {
+        const double omega = helper::validBiquadOmega(sampleRate, frequency);
+        const double alpha = helper::validBiquadAlpha(omega, q);
+        const double cosine = cos(omega);
+        const double amplitude = pow(10.0, gain / 40.0);
+        const double a0 = 1.0 + alpha / amplitude;
+        return Biquad(
+                (1.0 + alpha * amplitude) / a0,
+                -2.0 * cosine / a0,
+                (1.0 - alpha * amplitude) / a0,
+                -2.0 * cosine / a0,
+                (1.0 - alpha / amplitude) / a0);
+    }
+
+}
+
+#endif //TDAP_BIQUAD_IMPL_HPP
@@ -0,0 +1,207 @@
+#ifndef TDAP_BUCKET_AVERAGE_IMPL_HPP
+#define TDAP_BUCKET_AVERAGE_IMPL_HPP
+/*
+ * tdap/bucket-average-impl.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace tdap::average
+{
+    template<typename S, size_t MAX_BUCKETS>
+    BucketAverage<S, MAX_BUCKETS>::BucketAverage()
+    {
+        setAverage(0);
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    size_t BucketAverage<S, MAX_BUCKETS>::setApproximateWindowSize(
+            size_t windowSamples, double maxRelativeError,
+            size_t minimumPreferredBucketCount)
+    {
+        if (windowSamples < MIN_BUCKETS) {
+            throw std::invalid_argument("BucketAverage: window must have at least MIN_BUCKETS samples");
+        }
+        const size_t preferred = boundaries::force_between(
+                minimumPreferredBucketCount, MIN_BUCKETS, MAX_BUCKETS);
+        double minimumError = std::numeric_limits<double>::max();
+        size_t bestCount = MIN_BUCKETS;
+        // First try the preferred counts, then the smaller ones, both from
+        // the biggest count down.
+        for (size_t i = 0; i <= MAX_BUCKETS - MIN_BUCKETS; i++) {
+            const size_t count = i <= MAX_BUCKETS - preferred
+                                 ? MAX_BUCKETS - i
+                                 : preferred - 1 - (i - (MAX_BUCKETS - preferred + 1));
+            const size_t size = windowSamples / count;
+            if (size == 0) {
+                continue;
+            }
+            const double error =
+                    double(windowSamples - size * count) / windowSamples;
+            if (error < maxRelativeError) {
+                bestCount = count;
+                break;
+            }
+            if (error < minimumError) {
+                minimumError = error;
+                bestCount = count;
+            }
+        }
+        setBucketSizeAndCount(windowSamples / bestCount, bestCount);
+        return getWindowSize();
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    void BucketAverage<S, MAX_BUCKETS>::setBucketSizeAndCount(size_t size, size_t count)
+    {
+        if (size == 0) {
+            throw std::invalid_argument("BucketAverage: bucket size must be positive");
+        }
+        if (!boundaries::is_between(count, MIN_BUCKETS, MAX_BUCKETS)) {
+            throw std::invalid_argument("BucketAverage: bucket count must lie between MIN_BUCKETS and MAX_BUCKETS");
+        }
+        const S average = average_ / userScale_;
+        bucketCount_ = count;
+        bucketSize_ = size;
+        scale_ = userScale_ / getWindowSize();
+        setAverage(average);
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    void BucketAverage<S, MAX_BUCKETS>::setOutputScale(S scale)
+    {
+        if (!(scale > std::numeric_limits<S>::epsilon())) {
+            throw std::invalid_argument("BucketAverage: scale must be positive");
+        }
+        average_ *= scale / userScale_;
+        userScale_ = scale;
+        scale_ = userScale_ / getWindowSize();
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    void BucketAverage<S, MAX_BUCKETS>::setAverage(S average)
+    {
+        const S bucketValue = average * bucketSize_;
+        for (size_t i = 0; i < bucketCount_; i++) {
+            bucket_[i] = bucketValue;
+        }
+        current_ = 0;
+        remaining_ = bucketSize_;
+        partialSum_ = 0;
+        completeSum_ = bucketValue * (bucketCount_ - 1);
+        shadowSum_ = 0;
+        shadowBuckets_ = 0;
+        fill_ = average;
+        sum_ = completeSum_ + bucketValue;
+        average_ = average * userScale_;
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    void BucketAverage<S, MAX_BUCKETS>::completeBucket()
+    {
+        const S bucketSum = partialSum_;
+        fill_ = (completeSum_ + bucketSum) / getWindowSize();
+        bucket_[current_] = bucketSum;
+        current_ = current_ < bucketCount_ - 1 ? current_ + 1 : 0;
+        completeSum_ += bucketSum - bucket_[current_];
+        shadowSum_ += bucketSum;
+        if (++shadowBuckets_ == bucketCount_ - 1) {
+            completeSum_ = shadowSum_;
+            shadowSum_ = 0;
+            shadowBuckets_ = 0;
+        }
+        partialSum_ = 0;
+        remaining_ = bucketSize_;
+        sum_ = completeSum_ + remaining_ * fill_;
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    S BucketAverage<S, MAX_BUCKETS>::addInputGetAverage(S input)
+    {
+        partialSum_ += input;
+        remaining_--;
+        sum_ += input - fill_;
+        average_ = scale_ * sum_;
+        if (remaining_ == 0) {
+            completeBucket();
+        }
+        return average_;
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    void BucketAverage<S, MAX_BUCKETS>::addInputs(
+            const S *input, S *output, size_t samples)
+    {
+        while (samples > 0) {
+            const size_t block = std::min(samples, remaining_);
+            const S scale = scale_;
+            const S fill = fill_;
+            S partialSum = partialSum_;
+            S sum = sum_;
+            for (size_t i = 0; i < block; i++) {
+                const S value = input[i];
+                partialSum += value;
+                sum += value - fill;
+                output[i] = scale * sum;
+            }
+            partialSum_ = partialSum;
+            sum_ = sum;
+            remaining_ -= block;
+            average_ = output[block - 1];
+            if (remaining_ == 0) {
+                completeBucket();
+            }
+            input += block;
+            output += block;
+            samples -= block;
+        }
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    S BucketRms<S, MAX_BUCKETS>::addInputGetRms(S input)
+    {
+        return sqrt(average_.addInputGetAverage(input * input));
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    void BucketRms<S, MAX_BUCKETS>::addInputs(
+            const S *input, S *output, size_t samples)
+    {
+        for (size_t i = 0; i < samples; i++) {
+            output[i] = input[i] * input[i];
+        }
+        average_.addInputs(output, output, samples);
+        for (size_t i = 0; i < samples; i++) {
+            output[i] = sqrt(output[i]);
+        }
+    }
+
+    template<typename S, size_t MAX_BUCKETS>
+    S BucketRms<S, MAX_BUCKETS>::getRms() const
+    {
+        return sqrt(average_.getAverage());
+    }
+
+}
+
+#endif //TDAP_BUCKET_AVERAGE_IMPL_HPP
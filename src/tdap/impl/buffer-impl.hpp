@@ -0,0 +1,157 @@
+#ifndef TDAP_BUFFER_IMPL_HPP
+#define TDAP_BUFFER_IMPL_HPP
+/*
+ * tdap/buffer-impl.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+namespace tdap
+{
+    template<typename T, class ARRAY>
+    void ArrayTraits<T, ARRAY>::fill(const T &value)
+    {
+        T *data = alignedData();
+        const size_t size = self().paddedSize();
+        for (size_t i = 0; i < size; i++) {
+            data[i] = value;
+        }
+    }
+
+    template<typename T, class ARRAY>
+    void ArrayTraits<T, ARRAY>::zero()
+    {
+        std::memset(static_cast<void *>(alignedData()), 0, sizeof(T) * self().paddedSize());
+    }
+
+    template<typename T, class ARRAY>
+    template<class SOURCE>
+    void ArrayTraits<T, ARRAY>::copy(const ArrayTraits<T, SOURCE> &source)
+    {
+        const SOURCE &from = static_cast<const SOURCE &>(source);
+        if (from.size() != self().size()) {
+            throw std::invalid_argument("ArrayTraits::copy(): source has different size");
+        }
+        if (static_cast<const void *>(from.data()) != static_cast<const void *>(self().data())) {
+            // Equal sizes have equal padding
+            std::memcpy(static_cast<void *>(alignedData()),
+                        TDAP_ASSUME_ALIGNED(from.data(), BUFFER_ALIGNMENT),
+                        sizeof(T) * self().paddedSize());
+        }
+    }
+
+    template<typename T, class ARRAY>
+    template<class SOURCE>
+    void ArrayTraits<T, ARRAY>::copy(
+            size_t offset, const ArrayTraits<T, SOURCE> &source,
+            size_t sourceOffset, size_t length)
+    {
+        const SOURCE &from = static_cast<const SOURCE &>(source);
+        if (offset > self().size() || length > self().size() - offset) {
+            throw std::out_of_range("ArrayTraits::copy(): offset and length exceed size");
+        }
+        if (sourceOffset > from.size() || length > from.size() - sourceOffset) {
+            throw std::out_of_range("ArrayTraits::copy(): source offset and length exceed source size");
+        }
+        std::memmove(static_cast<void *>(self().data() + offset),
+                     from.data() + sourceOffset, sizeof(T) * length);
+    }
+
+    template<typename T, class ARRAY>
+    void ArrayTraits<T, ARRAY>::move(size_t destination, size_t source, size_t length)
+    {
+        const size_t size = self().size();
+        if (source > size || length > size - source ||
+            destination > size || length > size - destination) {
+            throw std::out_of_range("ArrayTraits::move(): source or destination and length exceed size");
+        }
+        std::memmove(static_cast<void *>(self().data() + destination),
+                     self().data() + source, sizeof(T) * length);
+    }
+
+    template<typename T>
+    size_t Buffer<T>::validSize(size_t size)
+    {
+        if (size <= std::numeric_limits<size_t>::max() / sizeof(T) - BUFFER_ALIGNMENT) {
+            return size;
+        }
+        throw std::invalid_argument("Buffer: size too big");
+    }
+
+    template<typename T>
+    T *Buffer<T>::allocate(size_t paddedSize)
+    {
+        if (paddedSize == 0) {
+            return nullptr;
+        }
+        void *data = ::operator new(sizeof(T) * paddedSize, std::align_val_t(BUFFER_ALIGNMENT));
+        std::memset(data, 0, sizeof(T) * paddedSize);
+        return static_cast<T *>(data);
+    }
+
+    template<typename T>
+    void Buffer<T>::free(T *data)
+    {
+        if (data) {
+            ::operator delete(static_cast<void *>(data), std::align_val_t(BUFFER_ALIGNMENT));
+        }
+    }
+
+    template<typename T>
+    Buffer<T>::Buffer(size_t size) :
+            size_(validSize(size)),
+            paddedSize_(paddedElements<T>(size_)),
+            data_(allocate(paddedSize_)) {}
+
+    template<typename T>
+    Buffer<T>::Buffer(size_t size, const T &value) : Buffer(size)
+    {
+        this->fill(value);
+    }
+
+    template<typename T>
+    Buffer<T>::Buffer(const Buffer &source) : Buffer(source.size_)
+    {
+        this->copy(source);
+    }
+
+    template<typename T>
+    Buffer<T>::Buffer(Buffer &&source) noexcept :
+            size_(source.size_),
+            paddedSize_(source.paddedSize_),
+            data_(source.data_)
+    {
+        source.size_ = 0;
+        source.paddedSize_ = 0;
+        source.data_ = nullptr;
+    }
+
+    template<typename T>
+    Buffer<T>::~Buffer()
+    {
+        free(data_);
+    }
+
+}
+
+#endif //TDAP_BUFFER_IMPL_HPP
@@ -0,0 +1,117 @@
+#ifndef TDAP_FILTER_ANALYSIS_IMPL_HPP
+#define TDAP_FILTER_ANALYSIS_IMPL_HPP
+/*
+ * tdap/filter-analysis-impl.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace tdap::filter
+{
+    template<typename T>
+    std::vector<ssize_t> getEffectiveImpulseResponseLengths(
+            const Filter<T> * const *filters, size_t count,
+            const FilterClone<T> &clone, size_t maxLength, double threshold,
+            size_t windowSize, size_t threads, const Filter<T> *weighting)
+    {
+        if (count > 0 && filters == nullptr) {
+            throw std::invalid_argument("getEffectiveImpulseResponseLengths: no filters");
+        }
+        if (!clone) {
+            throw std::invalid_argument("getEffectiveImpulseResponseLengths: no clone function");
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (filters[i] == nullptr) {
+                throw std::invalid_argument("getEffectiveImpulseResponseLengths: filter is null");
+            }
+        }
+        auto validClone = [&clone](const Filter<T> &filter) {
+            std::unique_ptr<Filter<T>> result = clone(filter);
+            if (result) {
+                return result;
+            }
+            throw std::invalid_argument("getEffectiveImpulseResponseLengths: clone function returned no filter");
+        };
+        std::vector<ssize_t> lengths(count, -1);
+        std::atomic<size_t> next(0);
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        auto analyze = [&]() {
+            try {
+                std::unique_ptr<Filter<T>> weightingClone;
+                if (weighting != nullptr) {
+                    weightingClone = validClone(*weighting);
+                }
+                Filter<T> &usedWeighting = weightingClone ?
+                                           *weightingClone :
+                                           Filter<T>::identity();
+                for (size_t i = next++; i < count; i = next++) {
+                    std::unique_ptr<Filter<T>> filter = validClone(*filters[i]);
+                    filter->reset();
+                    usedWeighting.reset();
+                    lengths[i] = Filter<T>::getEffectiveImpulseResponseLengthFast(
+                            *filter, maxLength, threshold, windowSize, usedWeighting);
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> guard(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                // Let other threads stop early
+                next = count;
+            }
+        };
+
+        size_t usedThreads = threads > 0 ? threads : std::thread::hardware_concurrency();
+        usedThreads = std::max(static_cast<size_t>(1), std::min(usedThreads, count));
+        std::vector<std::thread> workers;
+        workers.reserve(usedThreads - 1);
+        try {
+            for (size_t i = 1; i < usedThreads; i++) {
+                workers.emplace_back(analyze);
+            }
+        }
+        catch (...) {
+            next = count;
+            for (std::thread &worker : workers) {
+                worker.join();
+            }
+            throw;
+        }
+        analyze();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return lengths;
+    }
+
+}
+
+#endif //TDAP_FILTER_ANALYSIS_IMPL_HPP
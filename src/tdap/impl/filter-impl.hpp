@@ -23,23 +23,30 @@
 
 #include <algorithm>
 #include <tdap/average.hpp>
+#include <tdap/denormal.hpp>
 
 namespace tdap::filter
 {
     using namespace tdap::average;
 
     template<typename T>
-    Filter<T> ChannelFilter<T>::single()
+    ChannelFilterView<T> ChannelFilter<T>::single()
     {
-        class SingleFilter : public Filter<T>
-        {
-            ChannelFilter<T> * const flt;
-        public:
-            SingleFilter(ChannelFilter * const original) : flt(original) {}
+        return ChannelFilterView<T>(*this, 0);
+    }
+
+    template<typename T>
+    ChannelFilterView<T> ChannelFilter<T>::channel(size_t channel)
+    {
+        return ChannelFilterView<T>(*this, channel);
+    }
 
-            virtual T filter(const T input) { return flt->filter(0, input);  }
-        };
-        return SingleFilter(this);
+    template<typename T>
+    ChannelFilterView<T>::ChannelFilterView(ChannelFilter<T> &filter, size_t channel)
+            :
+            filter_(&filter),
+            channel_(IndexPolicy::force(channel, filter.getChannels()))
+    {
     }
 
     template<typename T>
@@ -70,7 +77,7 @@ namespace tdap::filter
 
             totalSum += square;
             average.addInput(square);
-            double windowAverage = average.getAverage() *  windowSize;
+            double windowAverage = average.getAverage() * usedWindowSize;
 
             if (
                     sample >= usedMinumLength &&
@@ -83,6 +90,21 @@ namespace tdap::filter
         return -1;
     }
 
+    template<typename T>
+    ssize_t Filter<T>::getEffectiveImpulseResponseLengthFast(Filter &filter,
+                                                             size_t maxLength,
+                                                             double threshold,
+                                                             size_t windowSize,
+                                                             Filter &weighting)
+    {
+        ZeroDenormals zeroDenormals;
+        if (filter.getMaximumPoleRadius() >= 1) {
+            // The impulse response does not decay
+            return -1;
+        }
+        return getEffectiveImpulseResponseLength(filter, maxLength, threshold, windowSize, weighting);
+    }
+
 }
 
 #endif //TDAP_FILTER_IMPL_HPP
@@ -0,0 +1,132 @@
+#ifndef TDAP_LIMITER_IMPL_HPP
+#define TDAP_LIMITER_IMPL_HPP
+/*
+ * tdap/limiter-impl.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace tdap::peak
+{
+    template<typename S, size_t CHANNELS>
+    size_t LookAheadLimiter<S, CHANNELS>::validMaxLookAhead(size_t samples)
+    {
+        if (samples > 0 && samples < average::ResynchronisingMovingAverage<double>::MAX_WINDOW_SAMPLES) {
+            return samples;
+        }
+        throw std::invalid_argument("LookAheadLimiter: maximum look-ahead must be positive and not too big.");
+    }
+
+    template<typename S, size_t CHANNELS>
+    LookAheadLimiter<S, CHANNELS>::LookAheadLimiter(size_t maxLookAheadSamples)
+            :
+            maxLookAhead_(validMaxLookAhead(maxLookAheadSamples)),
+            delay_(maxLookAhead_ * CHANNELS),
+            minimum_(maxLookAhead_ + 1),
+            average_(maxLookAhead_)
+    {
+        setLookAhead(maxLookAhead_);
+    }
+
+    template<typename S, size_t CHANNELS>
+    void LookAheadLimiter<S, CHANNELS>::setLookAhead(size_t samples)
+    {
+        if (samples > maxLookAhead_) {
+            throw std::invalid_argument("LookAheadLimiter: look-ahead cannot exceed maximum.");
+        }
+        lookAhead_ = samples;
+        minimum_.setWindowSize(lookAhead_ + 1);
+        average_.setWindowSize(std::max(lookAhead_, static_cast<size_t>(1)));
+        reset();
+    }
+
+    template<typename S, size_t CHANNELS>
+    void LookAheadLimiter<S, CHANNELS>::setThreshold(double threshold)
+    {
+        if (threshold > 0) {
+            threshold_ = threshold;
+            return;
+        }
+        throw std::invalid_argument("LookAheadLimiter: threshold must be positive.");
+    }
+
+    template<typename S, size_t CHANNELS>
+    void LookAheadLimiter<S, CHANNELS>::setReleaseSamples(double samples)
+    {
+        if (samples < 0) {
+            throw std::invalid_argument("LookAheadLimiter: release samples cannot be negative.");
+        }
+        releaseFactor_ = samples > 0 ? exp(-1.0 / samples) : 0.0;
+    }
+
+    template<typename S, size_t CHANNELS>
+    void LookAheadLimiter<S, CHANNELS>::reset()
+    {
+        delay_.zero();
+        delayPtr_ = 0;
+        minimum_.setValue(1);
+        average_.setAverage(1);
+        gain_ = 1;
+    }
+
+    template<typename S, size_t CHANNELS>
+    void LookAheadLimiter<S, CHANNELS>::process(
+            const S *input, S *output, size_t frames)
+    {
+        const double threshold = threshold_;
+        const double releaseFactor = releaseFactor_;
+        const size_t lookAhead = lookAhead_;
+        double gain = gain_;
+        size_t delayPtr = delayPtr_;
+        for (size_t frame = 0; frame < frames; frame++) {
+            const S *in = input + frame * CHANNELS;
+            S *out = output + frame * CHANNELS;
+            double peak = 0;
+            for (size_t channel = 0; channel < CHANNELS; channel++) {
+                peak = std::max(peak, static_cast<double>(fabs(in[channel])));
+            }
+            const double needed = peak > threshold ? threshold / peak : 1.0;
+            average_.addInput(minimum_.addInput(needed));
+            const double smoothed = average_.getAverage();
+            gain = smoothed < gain ? smoothed : smoothed + releaseFactor * (gain - smoothed);
+            if (lookAhead > 0) {
+                S *delayed = delay_.data() + delayPtr * CHANNELS;
+                for (size_t channel = 0; channel < CHANNELS; channel++) {
+                    const S value = in[channel];
+                    out[channel] = static_cast<S>(gain * delayed[channel]);
+                    delayed[channel] = value;
+                }
+                delayPtr = delayPtr + 1 < lookAhead ? delayPtr + 1 : 0;
+            }
+            else {
+                for (size_t channel = 0; channel < CHANNELS; channel++) {
+                    out[channel] = static_cast<S>(gain * in[channel]);
+                }
+            }
+        }
+        gain_ = gain;
+        delayPtr_ = delayPtr;
+    }
+
+}
+
+#endif //TDAP_LIMITER_IMPL_HPP
@@ -0,0 +1,263 @@
+#ifndef TDAP_PERCEPTIVE_RMS_IMPL_HPP
+#define TDAP_PERCEPTIVE_RMS_IMPL_HPP
+/*
+ * tdap/perceptive-rms-impl.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <tdap/power2.hpp>
+
+namespace tdap::average
+{
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    PerceptiveRms<S, BUCKETS, LEVELS>::PerceptiveRms() : follower_(1, 1, 1)
+    {
+        configure(48000, PERCEPTIVE_SECONDS, 4);
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    size_t PerceptiveRms<S, BUCKETS, LEVELS>::getBucketSize(size_t level) const
+    {
+        if (level < usedLevels_) {
+            return bucketSize_[level];
+        }
+        throw std::out_of_range("PerceptiveRms: level out of range");
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    size_t PerceptiveRms<S, BUCKETS, LEVELS>::getBucketCount(size_t level) const
+    {
+        if (level < usedLevels_) {
+            return bucketCount_[level];
+        }
+        throw std::out_of_range("PerceptiveRms: level out of range");
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    size_t PerceptiveRms<S, BUCKETS, LEVELS>::getWindowSize(size_t level) const
+    {
+        return getBucketSize(level) * getBucketCount(level);
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    S PerceptiveRms<S, BUCKETS, LEVELS>::getScale(size_t level) const
+    {
+        if (level < usedLevels_) {
+            return sqrt(outputScale_[level]);
+        }
+        throw std::out_of_range("PerceptiveRms: level out of range");
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    void PerceptiveRms<S, BUCKETS, LEVELS>::setLevel(
+            size_t level, double windowSamples, S scale)
+    {
+        const size_t window = std::max(2.0, round(windowSamples));
+        // Power of two bucket sizes, that do not decrease with the level,
+        // make all levels that complete a bucket at the same time the
+        // smallest ones.
+        const size_t minimumSize = Power2::next((window + BUCKETS - 1) / BUCKETS);
+        const size_t size = level > 0 ? std::max(bucketSize_[level - 1], minimumSize) : minimumSize;
+        bucketSize_[level] = size;
+        bucketCount_[level] = std::clamp((window + size / 2) / size, size_t(2), BUCKETS);
+        outputScale_[level] = scale * scale;
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    void PerceptiveRms<S, BUCKETS, LEVELS>::configure(
+            double sampleRate, double biggestWindowSeconds, double peakToRms,
+            size_t levels)
+    {
+        if (!(sampleRate >= 1 && sampleRate * MAX_SECONDS * 2 < std::numeric_limits<size_t>::max())) {
+            throw std::invalid_argument("PerceptiveRms: invalid sample rate");
+        }
+        usedLevels_ = boundaries::force_between(levels, 3, LEVELS);
+        const double peakScale = 1.0 / boundaries::force_between(peakToRms, 2.0, 10.0);
+        const double biggest = boundaries::force_between(
+                biggestWindowSeconds, PERCEPTIVE_SECONDS, MAX_SECONDS);
+        // Apart from the perceptive window, divide the levels over the
+        // smaller and bigger windows, in proportion to their logarithmic
+        // range, with at least one smaller window.
+        const double biggerWeight = log(biggest) - log(PERCEPTIVE_SECONDS);
+        const double smallerWeight = log(PERCEPTIVE_SECONDS) - log(PEAK_SECONDS);
+        const size_t extraLevels = usedLevels_ - 1;
+        size_t biggerLevels = biggerWeight * extraLevels / (smallerWeight + biggerWeight);
+        if (biggerWeight < 0.5 * M_LN2) {
+            biggerLevels = 0;
+        }
+        const size_t smallerLevels = extraLevels - biggerLevels;
+
+        for (size_t level = 0; level < smallerLevels; level++) {
+            const double exponent = 1.0 * (smallerLevels - level) / smallerLevels;
+            setLevel(level,
+                     sampleRate * PERCEPTIVE_SECONDS * pow(PEAK_PERCEPTIVE_RATIO, exponent),
+                     level == 0 ? peakScale : pow(PEAK_PERCEPTIVE_RATIO, exponent * 0.25));
+        }
+        setLevel(smallerLevels, sampleRate * PERCEPTIVE_SECONDS, 1.0);
+        for (size_t level = 1; level <= biggerLevels; level++) {
+            const double exponent = 1.0 * level / biggerLevels;
+            setLevel(smallerLevels + level,
+                     sampleRate * PERCEPTIVE_SECONDS * pow(biggest / PERCEPTIVE_SECONDS, exponent),
+                     1.0);
+        }
+        for (size_t level = usedLevels_; level < PADDED; level++) {
+            bucketSize_[level] = std::numeric_limits<size_t>::max() / 2;
+            bucketCount_[level] = 2;
+            outputScale_[level] = 0;
+        }
+        follower_ = integration::SmoothHoldMaxAttackRelease<S>(
+                PEAK_HOLD_SECONDS * sampleRate,
+                0.5 + 0.5 * PEAK_SECONDS * sampleRate,
+                PEAK_RELEASE_SECONDS * sampleRate);
+        setRms(0);
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    void PerceptiveRms<S, BUCKETS, LEVELS>::setRms(S rms)
+    {
+        const S average = rms * rms;
+        for (size_t level = 0; level < PADDED; level++) {
+            const bool used = level < usedLevels_;
+            const S bucketValue = used ? average * bucketSize_[level] : 0;
+            for (size_t bucket = 0; bucket < bucketCount_[level]; bucket++) {
+                bucket_[level][bucket] = bucketValue;
+            }
+            current_[level] = 0;
+            partialSum_[level] = 0;
+            completeSum_[level] = bucketValue * (bucketCount_[level] - 1);
+            shadowSum_[level] = 0;
+            shadowBuckets_[level] = 0;
+            fill_[level] = used ? average : 0;
+            sum_[level] = completeSum_[level] + bucketValue;
+            scale_[level] = outputScale_[level] / (bucketSize_[level] * bucketCount_[level]);
+        }
+        time_ = 0;
+        nextCompleteAt_ = bucketSize_[0];
+        follower_.setOutput(rms);
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    void PerceptiveRms<S, BUCKETS, LEVELS>::completeBuckets()
+    {
+        for (size_t level = 0; level < usedLevels_; level++) {
+            if ((time_ & (bucketSize_[level] - 1)) != 0) {
+                break;
+            }
+            const size_t count = bucketCount_[level];
+            const size_t size = bucketSize_[level];
+            const S bucketSum = partialSum_[level];
+            S &completeSum = completeSum_[level];
+            size_t &current = current_[level];
+            fill_[level] = (completeSum + bucketSum) / (size * count);
+            bucket_[level][current] = bucketSum;
+            current = current < count - 1 ? current + 1 : 0;
+            completeSum += bucketSum - bucket_[level][current];
+            shadowSum_[level] += bucketSum;
+            if (++shadowBuckets_[level] == count - 1) {
+                completeSum = shadowSum_[level];
+                shadowSum_[level] = 0;
+                shadowBuckets_[level] = 0;
+            }
+            partialSum_[level] = 0;
+            sum_[level] = completeSum + size * fill_[level];
+        }
+        nextCompleteAt_ = time_ + bucketSize_[0];
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    S PerceptiveRms<S, BUCKETS, LEVELS>::addSquareGetDetection(S square)
+    {
+        // The maximum is taken per vector lane: each level is compared with
+        // the level one vector before it, so that this loop is vectorised
+        // without fast-math. The lanes before the first level start at
+        // zero, as rounding errors can make an average of squares slightly
+        // negative.
+        constexpr size_t LANES = 16 / sizeof(S);
+        alignas(16) S maximum[LANES + PADDED];
+        for (size_t lane = 0; lane < LANES; lane++) {
+            maximum[lane] = 0;
+        }
+        for (size_t level = 0; level < PADDED; level++) {
+            partialSum_[level] += square;
+            sum_[level] += square - fill_[level];
+            const S scaled = scale_[level] * sum_[level];
+            maximum[level + LANES] = scaled > maximum[level] ? scaled : maximum[level];
+        }
+        const S * const laneMaximum = maximum + PADDED;
+        S result = laneMaximum[0];
+        for (size_t lane = 1; lane < LANES; lane++) {
+            result = laneMaximum[lane] > result ? laneMaximum[lane] : result;
+        }
+        if (++time_ == nextCompleteAt_) {
+            completeBuckets();
+        }
+        return follower_.integrate(sqrt(result));
+    }
+
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    void PerceptiveRms<S, BUCKETS, LEVELS>::addSquares(
+            const S *squares, S *detections, size_t samples)
+    {
+        for (size_t i = 0; i < samples; i++) {
+            detections[i] = addSquareGetDetection(squares[i]);
+        }
+    }
+
+    template<typename S, size_t CHANNELS, size_t BUCKETS, size_t LEVELS>
+    void LinkedPerceptiveRms<S, CHANNELS, BUCKETS, LEVELS>::addFrames(
+            const S *input, S *detections, size_t frames)
+    {
+        alignas(16) S squares[BLOCK];
+        while (frames > 0) {
+            const size_t block = std::min(frames, BLOCK);
+            // One channel at a time, so that the loops over frames can be
+            // vectorised.
+            for (size_t frame = 0; frame < block; frame++) {
+                squares[frame] = input[frame * CHANNELS] * input[frame * CHANNELS];
+            }
+            if (link_ == ChannelLink::MAXIMUM) {
+                for (size_t channel = 1; channel < CHANNELS; channel++) {
+                    for (size_t frame = 0; frame < block; frame++) {
+                        const S value = input[frame * CHANNELS + channel];
+                        squares[frame] = std::max(squares[frame], value * value);
+                    }
+                }
+            }
+            else {
+                for (size_t channel = 1; channel < CHANNELS; channel++) {
+                    for (size_t frame = 0; frame < block; frame++) {
+                        const S value = input[frame * CHANNELS + channel];
+                        squares[frame] += value * value;
+                    }
+                }
+            }
+            detector_.addSquares(squares, detections, block);
+            input += block * CHANNELS;
+            detections += block;
+            frames -= block;
+        }
+    }
+
+}
+
+#endif //TDAP_PERCEPTIVE_RMS_IMPL_HPP
@@ -0,0 +1,136 @@
+#ifndef TDAP_POWER2_HELPER_HPP
+#define TDAP_POWER2_HELPER_HPP
+/*
+ * tdap/power2-helper.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <type_traits>
+
+namespace tdap::power2::helper {
+
+    template<typename SIZE_T, bool CONST_EXPR>
+    struct FillBitsToRight;
+
+    template<typename SIZE_T>
+    class FillBitsToRight<SIZE_T, true>
+    {
+        template<size_t N>
+        static constexpr SIZE_T fillN(const SIZE_T n)
+        {
+            if constexpr (N < 2) {
+                return n;
+            }
+            else {
+                return fillN<N / 2>(n) | (fillN<N / 2>(n) >> (N / 2));
+            }
+        }
+
+    public:
+        static constexpr SIZE_T fill(const SIZE_T n)
+        {
+            return fillN<8 * sizeof(SIZE_T)>(n);
+        }
+    };
+
+    template<typename SIZE_T>
+    struct FillBitsToRight<SIZE_T, false>
+    {
+        static constexpr int BITS = sizeof(SIZE_T) * 8;
+
+        static inline SIZE_T fill(const SIZE_T x)
+        {
+            SIZE_T n = x;
+            for (int N = 1; N < BITS; N *= 2) {
+                n |= (n >> N);
+            }
+            return n;
+        }
+    };
+
+    template<bool CONST_EXPR, typename SIZE_T = size_t>
+    class Power2Helper : public FillBitsToRight<SIZE_T, CONST_EXPR>
+    {
+        static_assert(std::is_integral<SIZE_T>::value && !std::is_signed<SIZE_T>::value);
+
+        using FillBitsToRight<SIZE_T, CONST_EXPR>::fill;
+
+        static constexpr SIZE_T unchecked_aligned(SIZE_T value, SIZE_T alignment)
+        {
+            return ((value - 1) | (alignment - 1)) + 1;
+        }
+
+    public:
+        /**
+         * Returns whether the value is a power of two minus one.
+         */
+        static constexpr bool minus_one(const SIZE_T value)
+        {
+            return fill(value) == value;
+        }
+
+        /**
+         * Returns whether the value is a power of two.
+         */
+        static constexpr bool is(const SIZE_T value)
+        {
+            return value >= 2 ? minus_one(value - 1) : false;
+        }
+
+        /**
+         * Returns value if it is a power of two or else the next power of two
+         * that is greater.
+         */
+        static constexpr SIZE_T next(const SIZE_T value)
+        {
+            return fill(value - 1) + 1;
+        }
+
+        /**
+         * Returns value if it is a power of two or else the next power of two
+         * that is smaller.
+         */
+        static constexpr SIZE_T previous(const SIZE_T value)
+        {
+            return next(value / 2 + 1);
+        }
+
+        /**
+         * Returns value if it is smaller than the power and else the power of
+         * two minus one.
+         */
+        static constexpr SIZE_T within(const SIZE_T value, const SIZE_T powerOfTwo)
+        {
+            return (fill(value & ~(powerOfTwo - 1)) | value) & (powerOfTwo - 1);
+        }
+
+        /**
+         * Returns the value if it is aligned to power_of_two, the first higher
+         * value that is aligned to power_of_two or zero if the provided power
+         * of two is not actually a power of two.
+         */
+        static constexpr SIZE_T aligned_with(const SIZE_T value, const SIZE_T power_of_two)
+        {
+            return is(power_of_two) ? unchecked_aligned(value, power_of_two) : 0;
+        }
+    };
+}
+
+#endif //TDAP_POWER2_HELPER_HPP
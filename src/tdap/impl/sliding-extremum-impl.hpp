@@ -0,0 +1,77 @@
+#ifndef TDAP_SLIDING_EXTREMUM_IMPL_HPP
+#define TDAP_SLIDING_EXTREMUM_IMPL_HPP
+/*
+ * tdap/sliding-extremum-impl.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits>
+#include <stdexcept>
+#include <tdap/boundaries.hpp>
+#include <tdap/power2.hpp>
+
+namespace tdap::peak
+{
+    template<typename S, class DOMINATES>
+    size_t SlidingWindowExtremum<S, DOMINATES>::validMaxWindowSamples(size_t samples)
+    {
+        if (boundaries::is_between(samples, 1, std::numeric_limits<size_t>::max() / 4)) {
+            return samples;
+        }
+        throw std::invalid_argument("SlidingWindowExtremum: maximum window size must be positive and not too big.");
+    }
+
+    template<typename S, class DOMINATES>
+    SlidingWindowExtremum<S, DOMINATES>::SlidingWindowExtremum(size_t maxWindowSamples)
+            :
+            maxWindowSamples_(validMaxWindowSamples(maxWindowSamples)),
+            mask_(Power2::next(maxWindowSamples_ + 1) - 1),
+            values_(mask_ + 1),
+            times_(mask_ + 1),
+            windowSamples_(maxWindowSamples_)
+    {
+        setValue(0);
+    }
+
+    template<typename S, class DOMINATES>
+    void SlidingWindowExtremum<S, DOMINATES>::setWindowSize(size_t windowSamples)
+    {
+        if (!boundaries::is_between(windowSamples, 1, maxWindowSamples_)) {
+            throw std::invalid_argument("SlidingWindowExtremum: window samples must lie between 1 and maximum window size");
+        }
+        windowSamples_ = windowSamples;
+        // Keep at least the newest candidate
+        while (tail_ - head_ > 1 && time_ - 1 - times_[head_ & mask_] >= windowSamples_) {
+            head_++;
+        }
+    }
+
+    template<typename S, class DOMINATES>
+    void SlidingWindowExtremum<S, DOMINATES>::setValue(S value)
+    {
+        // A window of equal values leaves only the newest as a candidate
+        head_ = 0;
+        tail_ = 1;
+        values_[0] = value;
+        times_[0] = time_ - 1;
+    }
+
+}
+
+#endif //TDAP_SLIDING_EXTREMUM_IMPL_HPP
@@ -0,0 +1,133 @@
+#ifndef TDAP_INTEGRATION_HPP
+#define TDAP_INTEGRATION_HPP
+/*
+ * tdap/integration.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace tdap::integration
+{
+    /**
+     * Coefficients of a first order low-pass (RC) integrator, that moves
+     * the output towards the input by a fraction per sample, that
+     * corresponds with a number of characteristic samples.
+     */
+    template<typename F>
+    class IntegrationCoefficients
+    {
+        static_assert(std::is_floating_point<F>::value, "F must be a floating-point type");
+
+        F historyMultiply_ = 0;
+        F inputMultiply_ = 1;
+
+    public:
+        IntegrationCoefficients() = default;
+
+        explicit IntegrationCoefficients(double characteristicSamples)
+        {
+            setCharacteristicSamples(characteristicSamples);
+        }
+
+        F historyMultiply() const { return historyMultiply_; }
+
+        F inputMultiply() const { return inputMultiply_; }
+
+        void setCharacteristicSamples(double samples)
+        {
+            if (!(samples >= std::numeric_limits<F>::epsilon() &&
+                  samples <= 1.0 / std::numeric_limits<F>::epsilon())) {
+                throw std::invalid_argument("IntegrationCoefficients: characteristic samples out of range");
+            }
+            historyMultiply_ = exp(-1.0 / samples);
+            inputMultiply_ = 1.0 - historyMultiply_;
+        }
+
+        F integrate(const F input, F &output) const
+        {
+            return (output = inputMultiply_ * input + historyMultiply_ * output);
+        }
+    };
+
+    /**
+     * Follows its input with separate attack and release integrators, that
+     * are applied twice for a smooth result. A new maximum of the input is
+     * held for a number of samples before the follower releases.
+     */
+    template<typename F>
+    class SmoothHoldMaxAttackRelease
+    {
+        static_assert(std::is_floating_point<F>::value, "F must be a floating-point type");
+
+        IntegrationCoefficients<F> attack_;
+        IntegrationCoefficients<F> release_;
+        size_t holdSamples_;
+        size_t countDown_ = 0;
+        F maximum_ = 0;
+        F intermediate_ = 0;
+        F output_ = 0;
+
+        F integrate(const F input, F &output) const
+        {
+            return input > output ? attack_.integrate(input, output)
+                                  : release_.integrate(input, output);
+        }
+
+    public:
+        SmoothHoldMaxAttackRelease(size_t holdSamples, double attackSamples, double releaseSamples) :
+                attack_(attackSamples),
+                release_(releaseSamples),
+                holdSamples_(holdSamples) {}
+
+        F integrate(const F input)
+        {
+            F held = input;
+            if (input > maximum_) {
+                countDown_ = holdSamples_;
+                maximum_ = input;
+            }
+            else if (countDown_ > 0) {
+                countDown_--;
+                held = maximum_;
+            }
+            else {
+                maximum_ = output_;
+            }
+            return integrate(integrate(held, intermediate_), output_);
+        }
+
+        F getOutput() const { return output_; }
+
+        void setOutput(const F output)
+        {
+            intermediate_ = output;
+            output_ = output;
+            maximum_ = 0;
+            countDown_ = 0;
+        }
+    };
+
+}
+
+#endif //TDAP_INTEGRATION_HPP
@@ -0,0 +1,120 @@
+#ifndef TDAP_LIMITER_HPP
+#define TDAP_LIMITER_HPP
+/*
+ * tdap/limiter.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <tdap/average.hpp>
+#include <tdap/buffer.hpp>
+#include <tdap/sliding-extremum.hpp>
+
+namespace tdap::peak
+{
+    /**
+     * Limits the peaks of CHANNELS interleaved channels to a threshold, by
+     * delaying the signal and applying a gain that is already low enough
+     * when a peak leaves the delay. All stages are applied frame by frame in
+     * a single pass over a block:
+     * - the gain that each frame needs is the threshold divided by the
+     *   biggest absolute sample of the frame, if that is above threshold;
+     * - the exact minimum of that gain is held over look-ahead plus one
+     *   frames;
+     * - a rectangular average over look-ahead frames smooths that minimum;
+     * - an optional release slows down gain increases; and
+     * - the gain is applied to the frame that leaves the delay.
+     * As every held minimum that is averaged for a delayed frame includes
+     * the gain that frame needs, the output never exceeds the threshold.
+     * Gains are calculated in double precision, whatever the sample type.
+     *
+     * @tparam S the type of samples used
+     * @tparam CHANNELS the number of channels
+     */
+    template<typename S, size_t CHANNELS>
+    class LookAheadLimiter
+    {
+        static_assert(std::is_floating_point<S>::value, "Sample type must be floating point");
+        static_assert(CHANNELS > 0, "Number of channels must be positive");
+
+        const size_t maxLookAhead_;
+        Buffer<S> delay_;
+        SlidingWindowMin<double> minimum_;
+        average::ResynchronisingMovingAverage<double> average_;
+        size_t lookAhead_ = 0;
+        size_t delayPtr_ = 0;
+        double threshold_ = 1;
+        double releaseFactor_ = 0;
+        double gain_ = 1;
+
+        static size_t validMaxLookAhead(size_t samples);
+
+    public:
+        explicit LookAheadLimiter(size_t maxLookAheadSamples);
+
+        static constexpr size_t getChannels() { return CHANNELS; }
+
+        size_t getMaxLookAhead() const { return maxLookAhead_; }
+
+        /**
+         * Sets the look-ahead, that is also the attack time, in samples and
+         * resets the limiter.
+         */
+        void setLookAhead(size_t samples);
+
+        /**
+         * Returns the latency in samples, which equals the look-ahead.
+         */
+        size_t getLatency() const { return lookAhead_; }
+
+        void setThreshold(double threshold);
+
+        /**
+         * Sets the time constant in samples with which the gain recovers
+         * after limiting, on top of the look-ahead. Zero means that the gain
+         * recovers as fast as the look-ahead allows.
+         */
+        void setReleaseSamples(double samples);
+
+        /**
+         * Clears the delay and sets the gain to one.
+         */
+        void reset();
+
+        /**
+         * Limits frames of CHANNELS interleaved inputs and writes them,
+         * delayed by the latency, to output, which may be the same as
+         * input.
+         */
+        void process(const S *input, S *output, size_t frames);
+
+        /**
+         * Returns the gain that was applied to the most recent output frame.
+         */
+        double getGain() const { return gain_; }
+    };
+
+}
+
+#ifndef TDAP_INCLUDE_NO_IMPLEMENTATION
+#include <tdap/impl/limiter-impl.hpp>
+#endif
+
+#endif //TDAP_LIMITER_HPP
@@ -24,4 +24,27 @@
 #define TDAP_QUOTE_MACRO_OR_CONSTEXPR(x) #x
 #define TDAP_QUOTE(t) TDAP_QUOTE_MACRO_OR_CONSTEXPR(t)
 
+/*
+ * Tells the compiler that a pointer is aligned to a number of bytes, so that
+ * loops over it can be vectorised without alignment checks.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define TDAP_ASSUME_ALIGNED(pointer, bytes) \
+    static_cast<decltype(pointer)>(__builtin_assume_aligned((pointer), (bytes)))
+#else
+#define TDAP_ASSUME_ALIGNED(pointer, bytes) (pointer)
+#endif
+
+/*
+ * Qualifies a member function so that the compiler may assume that the
+ * members of the object are not accessed through other pointers in that
+ * function. Without that, loops that gather from an arbitrary pointer and
+ * write members are not vectorized.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define TDAP_RESTRICT_THIS __restrict
+#else
+#define TDAP_RESTRICT_THIS
+#endif
+
 #endif //TDAP_MACROS_HPP
@@ -0,0 +1,204 @@
+#ifndef TDAP_PERCEPTIVE_RMS_HPP
+#define TDAP_PERCEPTIVE_RMS_HPP
+/*
+ * tdap/perceptive-rms.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <tdap/boundaries.hpp>
+#include <tdap/integration.hpp>
+
+namespace tdap::average
+{
+    struct PerceptiveMetrics
+    {
+        static constexpr double PERCEPTIVE_SECONDS = 0.400;
+        static constexpr double PEAK_SECONDS = 0.0004;
+        static constexpr double PEAK_HOLD_SECONDS = 0.0050;
+        static constexpr double PEAK_RELEASE_SECONDS = 0.0100;
+        static constexpr double MAX_SECONDS = 10.0000;
+        static constexpr double PEAK_PERCEPTIVE_RATIO =
+                PEAK_SECONDS / PERCEPTIVE_SECONDS;
+    };
+
+    /**
+     * Detects the perceived level of a signal as the maximum of scaled RMS
+     * values over windows from a peak window to beyond the perceptive
+     * window, followed by a smooth hold-max attack-release follower.
+     *
+     * Each level is a bucket average of squares, like BucketAverage. The
+     * state of all levels is stored per quantity (structure of arrays), so
+     * that adding a square updates all levels in a single loop over the
+     * padded levels. That loop also takes the maximum per vector lane, as
+     * a running maximum is not vectorised without fast-math; the lanes are
+     * reduced after the loop. Unused levels have scale zero.
+     * Bucket sizes are powers of two that do not decrease with the level,
+     * so when buckets are complete, that is for the smallest levels, up to
+     * the first level that is not.
+     *
+     * @tparam S the type of samples used, normally "double"
+     * @tparam BUCKETS the maximum number of buckets per level
+     * @tparam LEVELS the maximum number of levels
+     */
+    template<typename S, size_t BUCKETS, size_t LEVELS>
+    class PerceptiveRms : public PerceptiveMetrics
+    {
+        static_assert(std::is_floating_point<S>::value, "Sample type must be floating point");
+        static_assert(boundaries::is_between(LEVELS, 3, 16), "Levels must be between 3 and 16");
+        static_assert(boundaries::is_between(BUCKETS, 2, 64), "Buckets must be between 2 and 64");
+
+        // Levels are padded, so that loops over them have no remainder
+        static constexpr size_t PADDED = LEVELS <= 4 ? 4 : LEVELS <= 8 ? 8 : 16;
+
+        // Updated for all levels per sample
+        alignas(16) S partialSum_[PADDED];
+        alignas(16) S sum_[PADDED];
+        alignas(16) S fill_[PADDED];
+        alignas(16) S scale_[PADDED];
+        // Updated for a level when its bucket is complete
+        S bucket_[PADDED][BUCKETS];
+        S completeSum_[PADDED];
+        S shadowSum_[PADDED];
+        S outputScale_[PADDED];
+        size_t shadowBuckets_[PADDED];
+        size_t current_[PADDED];
+        size_t bucketSize_[PADDED];
+        size_t bucketCount_[PADDED];
+        size_t nextCompleteAt_ = 0;
+        size_t time_ = 0;
+        size_t usedLevels_ = LEVELS;
+        integration::SmoothHoldMaxAttackRelease<S> follower_;
+
+        void setLevel(size_t level, double windowSamples, S scale);
+
+        void completeBuckets();
+
+    public:
+        PerceptiveRms();
+
+        size_t getUsedLevels() const { return usedLevels_; }
+
+        size_t getBucketSize(size_t level) const;
+
+        size_t getBucketCount(size_t level) const;
+
+        size_t getWindowSize(size_t level) const;
+
+        /**
+         * Returns the scale of the RMS of the level.
+         */
+        S getScale(size_t level) const;
+
+        /**
+         * Configures levels with windows between the peak window and the
+         * perceptive window, distributed logarithmically, the perceptive
+         * window itself and bigger windows up to the biggest window. The
+         * RMS of the peak window is scaled down by the peak to RMS ratio.
+         */
+        void configure(double sampleRate, double biggestWindowSeconds,
+                       double peakToRms, size_t levels = LEVELS);
+
+        /**
+         * Sets the RMS of all levels and the output of the follower.
+         */
+        void setRms(S rms);
+
+        /**
+         * Adds the square of a sample and returns the detected level.
+         */
+        S addSquareGetDetection(S square);
+
+        /**
+         * Adds a block of squares and writes the detected level after each
+         * one to detections, which may be the same as squares. Results are
+         * identical to calling addSquareGetDetection() for each square.
+         */
+        void addSquares(const S *squares, S *detections, size_t samples);
+    };
+
+    /**
+     * How a linked detector combines the squares of the channels of a frame.
+     */
+    enum class ChannelLink
+    {
+        /**
+         * The biggest square, so that the loudest channel determines the
+         * detection.
+         */
+        MAXIMUM,
+        /**
+         * The sum of squares, that is the power of all channels.
+         */
+        SUM
+    };
+
+    /**
+     * Detects a single perceived level for frames of interleaved channels,
+     * by combining the squares of each frame before they enter one
+     * PerceptiveRms. This costs one detector instead of one per channel.
+     * Note that with the MAXIMUM link, the detection follows the biggest
+     * square per frame, that is not smaller than the biggest of the
+     * detections of separate channels.
+     *
+     * @tparam S the type of samples used, normally "double"
+     * @tparam CHANNELS the number of interleaved channels
+     * @tparam BUCKETS the maximum number of buckets per level
+     * @tparam LEVELS the maximum number of levels
+     */
+    template<typename S, size_t CHANNELS, size_t BUCKETS, size_t LEVELS>
+    class LinkedPerceptiveRms
+    {
+        static_assert(boundaries::is_between(CHANNELS, 1, 64), "Channels must be between 1 and 64");
+
+        static constexpr size_t BLOCK = 64;
+
+        PerceptiveRms<S, BUCKETS, LEVELS> detector_;
+        ChannelLink link_ = ChannelLink::MAXIMUM;
+
+    public:
+        const PerceptiveRms<S, BUCKETS, LEVELS> &detector() const { return detector_; }
+
+        ChannelLink getLink() const { return link_; }
+
+        void setLink(ChannelLink link) { link_ = link; }
+
+        void configure(double sampleRate, double biggestWindowSeconds,
+                       double peakToRms, size_t levels = LEVELS)
+        {
+            detector_.configure(sampleRate, biggestWindowSeconds, peakToRms, levels);
+        }
+
+        void setRms(S rms) { detector_.setRms(rms); }
+
+        /**
+         * Adds frames of interleaved samples and writes the detected level
+         * after each frame to detections.
+         */
+        void addFrames(const S *input, S *detections, size_t frames);
+    };
+
+}
+
+#ifndef TDAP_INCLUDE_NO_IMPLEMENTATION
+#include <tdap/impl/perceptive-rms-impl.hpp>
+#endif
+
+#endif //TDAP_PERCEPTIVE_RMS_HPP
@@ -0,0 +1,39 @@
+#ifndef TDAP_POWER2_HPP
+#define TDAP_POWER2_HPP
+/*
+ * tdap/power2.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Power of two helpers, originally from attic/bounds.hpp. The branchless
+ * variants are meant for run-time use, while Power2::constant can be used in
+ * constant expressions, like template arguments.
+ */
+
+#include <tdap/impl/power2-helper.hpp>
+
+namespace tdap {
+
+    struct Power2 : public power2::helper::Power2Helper<false>
+    {
+        using constant = power2::helper::Power2Helper<true>;
+    };
+
+}
+
+#endif //TDAP_POWER2_HPP
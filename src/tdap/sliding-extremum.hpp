@@ -0,0 +1,132 @@
+#ifndef TDAP_SLIDING_EXTREMUM_HPP
+#define TDAP_SLIDING_EXTREMUM_HPP
+/*
+ * tdap/sliding-extremum.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <tdap/buffer.hpp>
+
+namespace tdap::peak
+{
+    /**
+     * Keeps the exact maximum or minimum of the most recent window of
+     * samples, using a monotonic queue of candidates: each new sample
+     * removes all older candidates that it dominates, so that the oldest
+     * remaining candidate is the extremum. Candidates leave the queue when
+     * they are older than the window. Each sample enters and leaves the
+     * queue once, so adding a sample costs O(1) amortised, regardless of the
+     * window size. Like the histories of averages, the queue is a ring with
+     * a power of two capacity that wraps with a mask.
+     *
+     * @tparam S the type of samples used
+     * @tparam DOMINATES returns whether its first argument makes its second
+     * one irrelevant: greater_equal for a maximum and less_equal for a
+     * minimum
+     */
+    template<typename S, class DOMINATES>
+    class SlidingWindowExtremum
+    {
+        static_assert(std::is_arithmetic<S>::value, "Sample type must be arithmetic");
+
+        const size_t maxWindowSamples_;
+        const size_t mask_;
+        Buffer<S> values_;
+        Buffer<size_t> times_;
+        size_t windowSamples_;
+        // Time of the next sample
+        size_t time_ = 0;
+        // Oldest and one past newest candidate
+        size_t head_ = 0;
+        size_t tail_ = 0;
+
+        static size_t validMaxWindowSamples(size_t samples);
+
+    public:
+        explicit SlidingWindowExtremum(size_t maxWindowSamples);
+
+        size_t getMaxWindowSamples() const { return maxWindowSamples_; }
+
+        size_t getWindowSize() const { return windowSamples_; }
+
+        /**
+         * Sets the window size. A smaller window takes effect immediately,
+         * but as samples that left the window are forgotten, a bigger window
+         * only includes samples that are added after this call.
+         */
+        void setWindowSize(size_t windowSamples);
+
+        /**
+         * Behaves as if a complete window of value was added.
+         */
+        void setValue(S value);
+
+        /**
+         * Adds the input and returns the extremum of the window.
+         */
+        S addInput(S input)
+        {
+            const size_t time = time_++;
+            while (tail_ != head_ && DOMINATES()(input, values_[(tail_ - 1) & mask_])) {
+                tail_--;
+            }
+            values_[tail_ & mask_] = input;
+            times_[tail_ & mask_] = time;
+            tail_++;
+            // The new sample is always a candidate, so the queue is never empty
+            while (time - times_[head_ & mask_] >= windowSamples_) {
+                head_++;
+            }
+            return values_[head_ & mask_];
+        }
+
+        /**
+         * Adds the inputs and writes the extremum after each input to
+         * output, which may be the same as input.
+         */
+        void addInputs(const S *input, S *output, size_t samples)
+        {
+            for (size_t i = 0; i < samples; i++) {
+                output[i] = addInput(input[i]);
+            }
+        }
+
+        /**
+         * Returns the extremum of the window, which is zero before a value
+         * or input was added, as the constructor sets a window of zeroes.
+         */
+        S getValue() const { return values_[head_ & mask_]; }
+    };
+
+    template<typename S>
+    using SlidingWindowMax = SlidingWindowExtremum<S, std::greater_equal<S>>;
+
+    template<typename S>
+    using SlidingWindowMin = SlidingWindowExtremum<S, std::less_equal<S>>;
+
+}
+
+#ifndef TDAP_INCLUDE_NO_IMPLEMENTATION
+#include <tdap/impl/sliding-extremum-impl.hpp>
+#endif
+
+#endif //TDAP_SLIDING_EXTREMUM_HPP
@@ -0,0 +1,82 @@
+#ifndef TDAP_TRIPLE_BUFFER_HPP
+#define TDAP_TRIPLE_BUFFER_HPP
+/*
+ * tdap/triple-buffer.hpp
+ *
+ * Part of Time-domain Audio Processing (TDAP)
+ * Copyright (C) 2015-2019 Michel Fleur.
+ * Source https://github.com/emmef/tdap
+ * Email  tdap@emmef.org
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+
+namespace tdap
+{
+    /**
+     * Passes values from one writer thread to one reader thread without locks
+     * and without waiting. The writer fills its own slot and publishes it, the
+     * reader consumes the most recently published slot. Slots are exchanged
+     * through a single atomic, so neither thread ever sees a value that is
+     * being written.
+     */
+    template<typename T>
+    class TripleBuffer
+    {
+        static constexpr unsigned INDEX = 3;
+        static constexpr unsigned FRESH = 4;
+
+        T slots_[3];
+        unsigned write_ = 0;
+        unsigned read_ = 1;
+        std::atomic<unsigned> middle_ = 2;
+
+    public:
+        /**
+         * Returns the slot that is owned by the writer.
+         */
+        T &writeSlot() { return slots_[write_]; }
+
+        /**
+         * Publishes the writer slot, after which the writer owns another slot
+         * with undefined contents.
+         */
+        void publish()
+        {
+            write_ = middle_.exchange(write_ | FRESH, std::memory_order_acq_rel) & INDEX;
+        }
+
+        /**
+         * Takes the most recently published slot if it was not consumed yet
+         * and returns whether that happened.
+         */
+        bool consume()
+        {
+            if ((middle_.load(std::memory_order_relaxed) & FRESH) == 0) {
+                return false;
+            }
+            read_ = middle_.exchange(read_, std::memory_order_acq_rel) & INDEX;
+            return true;
+        }
+
+        /**
+         * Returns the slot that is owned by the reader.
+         */
+        const T &readSlot() const { return slots_[read_]; }
+    };
+
+}
+
+#endif //TDAP_TRIPLE_BUFFER_HPP
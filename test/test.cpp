@@ -23,24 +23,1384 @@
  */
 
 #include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
 #include <tdap/average.hpp>
+#include <tdap/bucket-average.hpp>
 #include <tdap/filter.hpp>
+#include <tdap/biquad.hpp>
+#include <tdap/filter-chain.hpp>
+#include <tdap/filter-analysis.hpp>
 #include <tdap/boundaries.hpp>
+#include <tdap/sliding-extremum.hpp>
+#include <tdap/limiter.hpp>
+#include <tdap/perceptive-rms.hpp>
+#include <tdap/buffer.hpp>
 
 using namespace std;
 
 using DoubleFilter = tdap::filter::Filter<double>;
 using DoubleChannelFilter = tdap::filter::ChannelFilter<double>;
+using DoubleAverage = tdap::average::TrueFloatingPointWeightedMovingAverage<double>;
+
+static bool blockAverageEqualsPerSampleAverage(size_t windowSize, size_t blockSize, bool smallerWindow)
+{
+    DoubleAverage perSample(windowSize, 100 * windowSize);
+    DoubleAverage block(windowSize, 100 * windowSize);
+    perSample.setAverage(0);
+    block.setAverage(0);
+    if (smallerWindow) {
+        // Unlike setWindowSize(), this keeps the whole history active, so
+        // that the read pointer wraps at other samples than the write pointer
+        perSample.rampWindowSize(windowSize / 2 + 1, 0);
+        block.rampWindowSize(windowSize / 2 + 1, 0);
+    }
+    std::mt19937 random(windowSize);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    std::vector<double> input(10 * windowSize + 3);
+    std::vector<double> output(input.size());
+    for (double &value : input) {
+        value = distribution(random);
+    }
+    for (size_t offset = 0; offset < input.size(); offset += blockSize) {
+        size_t samples = std::min(blockSize, input.size() - offset);
+        block.addInputs(input.data() + offset, output.data() + offset, samples);
+    }
+    for (size_t i = 0; i < input.size(); i++) {
+        perSample.addInput(input[i]);
+        if (perSample.getAverage() != output[i]) {
+            cout << "Block average (window " << windowSize << ", block "
+                 << blockSize << ", smaller window " << smallerWindow
+                 << ") differs at sample " << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool multiChannelAverageEqualsSingleChannelAverages(size_t windowSize)
+{
+    static constexpr size_t CHANNELS = 4;
+    static constexpr size_t FRAMES = 5000;
+    tdap::average::MultiChannelMovingAverage<double, CHANNELS> multi(2000, 100000);
+    multi.setWindowSize(windowSize);
+    std::vector<double> input(FRAMES * CHANNELS);
+    std::vector<double> output(input.size());
+    std::mt19937 random(windowSize);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    for (double &value : input) {
+        value = distribution(random);
+    }
+    // Shrinks and grows the window in the middle of the input
+    static constexpr size_t SHRINK_FRAME = 2003;
+    static constexpr size_t GROW_FRAME = 3001;
+    const size_t smallerWindowSize = windowSize / 3 + 1;
+    multi.addFrames(input.data(), output.data(), SHRINK_FRAME);
+    multi.setWindowSize(smallerWindowSize);
+    multi.addFrames(input.data() + SHRINK_FRAME * CHANNELS, output.data() + SHRINK_FRAME * CHANNELS,
+                    GROW_FRAME - SHRINK_FRAME);
+    multi.setWindowSize(windowSize);
+    multi.addFrames(input.data() + GROW_FRAME * CHANNELS, output.data() + GROW_FRAME * CHANNELS,
+                    FRAMES - GROW_FRAME);
+    for (size_t channel = 0; channel < CHANNELS; channel++) {
+        DoubleAverage single(2000, 100000);
+        single.setAverage(0);
+        single.setWindowSize(windowSize);
+        for (size_t frame = 0; frame < FRAMES; frame++) {
+            if (frame == SHRINK_FRAME) {
+                single.setWindowSize(smallerWindowSize);
+            }
+            else if (frame == GROW_FRAME) {
+                single.setWindowSize(windowSize);
+            }
+            single.addInput(input[frame * CHANNELS + channel]);
+            if (single.getAverage() != output[frame * CHANNELS + channel]) {
+                cout << "Multi-channel average (window " << windowSize
+                     << ") differs at frame " << frame << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<bool POWER2_CAPACITY>
+static bool fixedCapacityAverageEqualsDynamicAverage(size_t windowSize)
+{
+    static constexpr size_t SAMPLES = 5000;
+    static constexpr size_t BLOCK = 7;
+    tdap::average::FixedCapacityTrueFloatingPointWeightedMovingAverage<
+            double, 2000, 20, 10, POWER2_CAPACITY> fixed(100000);
+    fixed.setAverage(0);
+    fixed.setWindowSize(windowSize);
+    DoubleAverage dynamic(2000, 100000);
+    dynamic.setAverage(0);
+    dynamic.setWindowSize(windowSize);
+    std::mt19937 random(windowSize);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    double output[BLOCK];
+    for (size_t i = 0; i < SAMPLES; i += BLOCK) {
+        double input[BLOCK];
+        for (double &value : input) {
+            value = distribution(random);
+        }
+        fixed.addInputs(input, output, BLOCK);
+        for (size_t j = 0; j < BLOCK; j++) {
+            dynamic.addInput(input[j]);
+            if (dynamic.getAverage() != output[j]) {
+                cout << "Fixed capacity average (window " << windowSize
+                     << ", power of two " << POWER2_CAPACITY
+                     << ") differs at sample " << (i + j) << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool power2HistoryAverageEqualsAverage(size_t windowSize)
+{
+    static constexpr size_t SAMPLES = 5000;
+    static constexpr size_t BLOCK = 7;
+    tdap::average::TrueFloatingPointWeightedMovingAverage<
+            double, 20, 10, true> power2(2000, 100000);
+    DoubleAverage average(2000, 100000);
+    power2.setAverage(0);
+    average.setAverage(0);
+    // Shrink the active history first, so that it needs to grow again
+    power2.setWindowSize(64);
+    average.setWindowSize(64);
+    power2.setWindowSize(windowSize);
+    average.setWindowSize(windowSize);
+    std::mt19937 random(windowSize);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    double output[BLOCK];
+    for (size_t i = 0; i < SAMPLES; i += BLOCK) {
+        double input[BLOCK];
+        for (double &value : input) {
+            value = distribution(random);
+        }
+        power2.addInputs(input, output, BLOCK);
+        for (size_t j = 0; j < BLOCK; j++) {
+            average.addInput(input[j]);
+            if (average.getAverage() != output[j]) {
+                cout << "Power of two history average (window " << windowSize
+                     << ") differs at sample " << (i + j) << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool compensatedFloatAverageIsPrecise(size_t windowSize)
+{
+    static constexpr size_t CHANNELS = 3;
+    static constexpr size_t FRAMES = 300000;
+    static constexpr size_t BLOCK = 100;
+    static constexpr double MAX_RELATIVE_ERROR = 1.0 / (1 << 20);
+    tdap::average::CompensatedMultiChannelMovingAverage<float, CHANNELS> average(windowSize);
+    std::mt19937 random(windowSize);
+    // A large offset makes uncompensated float sums lose most precision
+    std::uniform_real_distribution<float> distribution(999.0, 1001.0);
+    std::vector<float> input(FRAMES * CHANNELS);
+    for (float &value : input) {
+        value = distribution(random);
+    }
+    std::vector<float> output(FRAMES * CHANNELS);
+    for (size_t frame = 0; frame < FRAMES; frame += BLOCK) {
+        average.addFrames(input.data() + frame * CHANNELS, output.data() + frame * CHANNELS, BLOCK);
+    }
+    // Sums of these floats are exact in double
+    double sum[CHANNELS] = {0};
+    for (size_t frame = 0; frame < FRAMES; frame++) {
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            sum[channel] += input[frame * CHANNELS + channel];
+            if (frame >= windowSize) {
+                sum[channel] -= input[(frame - windowSize) * CHANNELS + channel];
+            }
+            const double expected = sum[channel] / windowSize;
+            const double actual = output[frame * CHANNELS + channel];
+            if (fabs(actual - expected) > MAX_RELATIVE_ERROR * expected) {
+                cout << "Compensated float average (window " << windowSize
+                     << ") is imprecise at frame " << frame << " of channel " << channel
+                     << ": " << actual << " instead of " << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool preciseAveragesAreExact(size_t windowSize, size_t windows)
+{
+    static constexpr size_t SAMPLES = 20000;
+    tdap::average::PreciseWindowAverage<> average(windowSize);
+    tdap::average::PreciseWindowAverageSet<> set(windowSize, windows, 0);
+    std::mt19937 random(windowSize);
+    // Full scale 24-bit PCM
+    std::uniform_int_distribution<int32_t> distribution(-(1 << 23), (1 << 23) - 1);
+    std::vector<int32_t> input(SAMPLES);
+    for (int32_t &value : input) {
+        value = distribution(random);
+    }
+    for (size_t i = 0; i < SAMPLES; i++) {
+        if (i == SAMPLES / 2) {
+            average.setWindowSize(windowSize / 2 + 1);
+            set.setUsedWindows(windows - 1);
+        }
+        average.addInput(input[i]);
+        const double maximum = set.addInputGetMax(input[i], -1e100);
+        double expectedMaximum = -1e100;
+        for (size_t window = 0; window < set.getUsedWindows(); window++) {
+            const size_t samples = set.getWindowSize(window);
+            int64_t sum = 0;
+            for (size_t j = 0; j < samples; j++) {
+                sum += i >= j ? input[i - j] : 0;
+            }
+            if (set.getSum(window) != sum) {
+                cout << "Precise average set window " << samples << " has sum "
+                     << set.getSum(window) << " instead of " << sum << " at sample " << i << endl;
+                return false;
+            }
+            expectedMaximum = std::max(expectedMaximum, set.getAverage(window));
+        }
+        int64_t sum = 0;
+        for (size_t j = 0; j < average.getWindowSize(); j++) {
+            sum += i >= j ? input[i - j] : 0;
+        }
+        if (average.getSum() != sum || maximum != expectedMaximum) {
+            cout << "Precise average (window " << average.getWindowSize()
+                 << ") is not exact at sample " << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool resynchronisingAverageIsPrecise(size_t windowSize, size_t blockSize)
+{
+    static constexpr size_t SAMPLES = 50000;
+    tdap::average::ResynchronisingMovingAverage<double> average(windowSize);
+    tdap::average::ResynchronisingMovingAverage<double> block(windowSize);
+    std::mt19937 random(windowSize);
+    std::uniform_real_distribution<double> distribution(999.0, 1001.0);
+    std::vector<double> input(SAMPLES);
+    for (double &value : input) {
+        value = distribution(random);
+    }
+    std::vector<double> output(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; i += blockSize) {
+        block.addInputs(input.data() + i, output.data() + i, std::min(blockSize, SAMPLES - i));
+    }
+    // The running sum is never worse than the sum of a single window
+    const double maxRelativeError = 4.0 * windowSize * std::numeric_limits<double>::epsilon();
+    for (size_t i = 0; i < SAMPLES; i++) {
+        average.addInput(input[i]);
+        if (average.getAverage() != output[i]) {
+            cout << "Resynchronising block average (window " << windowSize
+                 << ", block " << blockSize << ") differs at sample " << i << endl;
+            return false;
+        }
+        long double sum = 0;
+        for (size_t j = 0; j < windowSize; j++) {
+            sum += i >= j ? input[i - j] : 0;
+        }
+        const double expected = sum / windowSize;
+        if (fabs(average.getAverage() - expected) > maxRelativeError * expected) {
+            cout << "Resynchronising average (window " << windowSize
+                 << ") is imprecise at sample " << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename S>
+static bool windowSumTreeEqualsWindowSums(size_t maxWindowSize)
+{
+    static constexpr size_t SAMPLES = 5000;
+    tdap::average::WindowSumTree<S> tree(maxWindowSize);
+    tree.setAverage(3);
+    std::mt19937 random(maxWindowSize);
+    std::uniform_int_distribution<int> distribution(-1000000, 1000000);
+    std::uniform_int_distribution<size_t> windows(1, maxWindowSize);
+    std::vector<S> input(SAMPLES);
+    for (S &value : input) {
+        value = std::is_integral<S>::value ? distribution(random) : distribution(random) / 1000.0;
+    }
+    for (size_t i = 0; i < SAMPLES; i++) {
+        tree.addInput(input[i]);
+        for (size_t query = 0; query < 4; query++) {
+            const size_t windowSize = query == 0 ? maxWindowSize : windows(random);
+            long double expected = 0;
+            for (size_t j = 0; j < windowSize; j++) {
+                expected += i >= j ? input[i - j] : 3;
+            }
+            const long double sum = tree.getSum(windowSize);
+            const long double maximumError = std::is_integral<S>::value ? 0 : 1e-12 * windowSize * 1000;
+            if (fabsl(sum - expected) > maximumError) {
+                cout << "Window sum tree (maximum " << maxWindowSize << ") has sum " << sum
+                     << " instead of " << expected << " for window " << windowSize
+                     << " at sample " << i << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<bool POWER2_HISTORY>
+static bool averageSetEqualsSeparateAverages(size_t windows)
+{
+    static constexpr size_t SAMPLES = 6000;
+    static constexpr size_t MAX_WINDOW = 2000;
+    static constexpr size_t EMD = 100000;
+    using Average = tdap::average::TrueFloatingPointWeightedMovingAverage<double, 20, 10, POWER2_HISTORY>;
+    using Set = tdap::average::TrueFloatingPointWeightedMovingAverageSet<double, 20, 10, POWER2_HISTORY>;
+    Set set(MAX_WINDOW, EMD, windows, 0);
+    std::vector<std::unique_ptr<Average>> averages;
+    std::vector<double> scales;
+    for (size_t i = 0; i < windows; i++) {
+        const size_t windowSize = 1 + (i * 337) % 1500;
+        const double scale = 0.5 + 0.05 * i;
+        averages.emplace_back(new Average(MAX_WINDOW, EMD));
+        averages.back()->setWindowSize(windowSize);
+        averages.back()->setAverage(0);
+        set.setWindowSizeAndScale(i, windowSize, scale);
+        scales.push_back(scale);
+    }
+    set.setAverages(0);
+    std::mt19937 random(windows);
+    std::uniform_real_distribution<double> distribution(0, 1);
+    for (size_t sample = 0; sample < SAMPLES; sample++) {
+        const double input = distribution(random);
+        const double maximum = set.addInputGetMax(input, 0);
+        double expectedMaximum = 0;
+        for (size_t i = 0; i < windows; i++) {
+            averages[i]->addInput(input);
+            const double expected = scales[i] * averages[i]->getAverage();
+            expectedMaximum = std::max(expectedMaximum, expected);
+            if (set.getAverage(i) != expected) {
+                cout << "Average set window " << i << " of " << windows
+                     << " (power of two " << POWER2_HISTORY << ") is "
+                     << set.getAverage(i) << " instead of " << expected
+                     << " at sample " << sample << endl;
+                return false;
+            }
+        }
+        if (maximum != expectedMaximum) {
+            cout << "Average set maximum of " << windows << " windows is " << maximum
+                 << " instead of " << expectedMaximum << " at sample " << sample << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool lazyAverageSetEqualsAverageSet()
+{
+    static constexpr size_t SAMPLES = 8000;
+    static constexpr size_t EMD = 20000;
+    static constexpr double MAXIMUM_ERROR = 1e-9;
+    using Set = tdap::average::TrueFloatingPointWeightedMovingAverageSet<double, 20, 10>;
+    using LazySet = tdap::average::LazyTrueFloatingPointWeightedMovingAverageSet<double, 20, 10>;
+    Set set(1000, EMD, 4, 0.5);
+    LazySet lazy(1000, EMD, 4, 0.5);
+    // The set constructor does not set the window averages
+    set.setAverages(0.5);
+    std::mt19937 random(SAMPLES);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    std::vector<double> input(SAMPLES);
+    for (double &value : input) {
+        value = distribution(random);
+    }
+    for (size_t i = 0; i < SAMPLES; i += 100) {
+        for (size_t j = i; j < i + 100; j++) {
+            set.addInput(input[j]);
+        }
+        lazy.addInputs(input.data() + i, 100);
+        if (i == SAMPLES / 2) {
+            lazy.setWindowSizeAndScale(1, 300, 2.0);
+        }
+        for (size_t window = 0; window < lazy.getUsedWindows(); window++) {
+            double expected = set.getAverage(window);
+            if (window == 1 && i >= SAMPLES / 2) {
+                // Changed window is calculated directly
+                const double emdFactor = exp(-1.0 / EMD);
+                double inputFactor;
+                double historyFactor;
+                tdap::average::helper::getWindowFactorsForEmd(
+                        emdFactor, EMD, 300, inputFactor, historyFactor);
+                double sum = 0;
+                for (size_t k = 0; k < 300; k++) {
+                    sum += pow(emdFactor, k) * input[i + 99 - k];
+                }
+                expected = 2.0 * inputFactor * sum;
+            }
+            if (fabs(lazy.getAverage(window) - expected) > MAXIMUM_ERROR) {
+                cout << "Lazy average set window " << window << " differs at sample "
+                     << i << ": " << lazy.getAverage(window) << " instead of " << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Compares averages of squares with large ratios of error mitigating decay
+ * to window size with directly calculated averages, and checks that window
+ * sizes that would be less precise than SNR_BITS are rejected.
+ */
+static bool lazyAverageSetIsPreciseForLongDecays()
+{
+    static constexpr size_t SAMPLES = 100000;
+    using LazySet = tdap::average::LazyTrueFloatingPointWeightedMovingAverageSet<double, 20, 10>;
+    using FloatLazySet = tdap::average::LazyTrueFloatingPointWeightedMovingAverageSet<float, 8, 10>;
+    std::mt19937 random(SAMPLES);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    std::vector<double> input(SAMPLES);
+    for (double &value : input) {
+        value = distribution(random);
+        value *= value;
+    }
+    LazySet lazy(1000, 1000000, 2, 0.0);
+    lazy.setWindowSizeAndScale(0, 1, 1.0);
+    lazy.setWindowSizeAndScale(1, 10, 1.0);
+    FloatLazySet floatLazy(1000, 10000, 1, 0.0);
+    const size_t floatWindow = floatLazy.getMinimumWindowSamples();
+    try {
+        floatLazy.setWindowSizeAndScale(0, floatWindow - 1, 1.0);
+        cout << "Lazy float average set accepts imprecise window size" << endl;
+        return false;
+    }
+    catch (const std::out_of_range &) {
+    }
+    try {
+        tdap::average::LazyTrueFloatingPointWeightedMovingAverageSet<float, 12, 10> imprecise(1000, 10000, 1, 0.0);
+        cout << "Lazy float average set accepts 12 bits of precision" << endl;
+        return false;
+    }
+    catch (const std::invalid_argument &) {
+    }
+    floatLazy.setWindowSizeAndScale(0, floatWindow, 1.0);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        lazy.addInput(input[i]);
+        floatLazy.addInput(static_cast<float>(input[i]));
+        if (i % 97 != 0 || i < 1000) {
+            continue;
+        }
+        for (size_t window = 0; window < 3; window++) {
+            const bool isFloat = window == 2;
+            const size_t emd = isFloat ? 10000 : 1000000;
+            const size_t samples = isFloat ? floatWindow : lazy.getWindowSize(window);
+            const double emdFactor = exp(-1.0 / emd);
+            double inputFactor;
+            double historyFactor;
+            tdap::average::helper::getWindowFactorsForEmd(
+                    emdFactor, emd, samples, inputFactor, historyFactor);
+            double sum = 0;
+            for (size_t k = 0; k < samples; k++) {
+                sum += pow(emdFactor, k) * input[i - k];
+            }
+            const double expected = inputFactor * sum;
+            const double actual = isFloat ? floatLazy.getAverage(0) : lazy.getAverage(window);
+            const double bits = isFloat ? 8 : 20;
+            // The error is relative to the signal level, the mean square
+            if (fabs(actual - expected) > pow(2.0, -bits) / 3) {
+                cout << "Lazy average set with decay " << emd << " and window " << samples
+                     << " is imprecise at sample " << i << ": " << actual
+                     << " instead of " << expected << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool rampedWindowEqualsFixedWindow(size_t from, size_t to, size_t rampSamples, size_t blockSize)
+{
+    static constexpr size_t SAMPLES = 6000;
+    DoubleAverage ramped(2000, 100000);
+    DoubleAverage fixed(2000, 100000);
+    ramped.setAverage(0);
+    fixed.setAverage(0);
+    // Ramp immediately, as setWindowSize() would discard the history that
+    // is needed to grow
+    ramped.rampWindowSize(from, 0);
+    fixed.setWindowSize(to);
+    std::mt19937 random(from + to);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    std::vector<double> input(SAMPLES);
+    for (double &value : input) {
+        value = distribution(random);
+    }
+    std::vector<double> output(SAMPLES);
+    const size_t rampStart = 2000;
+    for (size_t i = 0; i < rampStart; i++) {
+        ramped.addInput(input[i]);
+    }
+    ramped.rampWindowSize(to, rampSamples);
+    for (size_t i = rampStart; i < SAMPLES; i += blockSize) {
+        ramped.addInputs(input.data() + i, output.data() + i, std::min(blockSize, SAMPLES - i));
+    }
+    for (size_t i = 0; i < SAMPLES; i++) {
+        fixed.addInput(input[i]);
+        if (i >= rampStart + rampSamples && fabs(fixed.getAverage() - output[i]) > 1e-12) {
+            cout << "Window ramped from " << from << " to " << to
+                 << " differs from fixed window at sample " << i << endl;
+            return false;
+        }
+    }
+    if (blockSize == 1 && rampSamples > 1) {
+        // While ramping, the average is that of the current window size
+        DoubleAverage checked(2000, 100000);
+        checked.setAverage(0);
+        checked.rampWindowSize(from, 0);
+        for (size_t i = 0; i < rampStart; i++) {
+            checked.addInput(input[i]);
+        }
+        checked.rampWindowSize(to, rampSamples);
+        const double emdFactor = exp(-1.0 / 100000);
+        for (size_t i = rampStart; i < rampStart + rampSamples; i++) {
+            checked.addInput(input[i]);
+            const size_t window = checked.getWindowSize();
+            double inputFactor;
+            double historyFactor;
+            tdap::average::helper::getWindowFactorsForEmd(
+                    emdFactor, 100000, window, inputFactor, historyFactor);
+            double sum = 0;
+            for (size_t k = 0; k < window; k++) {
+                sum += pow(emdFactor, k) * input[i - k];
+            }
+            if (fabs(inputFactor * sum - checked.getAverage()) > 1e-9) {
+                cout << "Window ramping from " << from << " to " << to
+                     << " has wrong average at sample " << i << " (window " << window << ")" << endl;
+                return false;
+            }
+        }
+    }
+    if (ramped.getWindowSize() != to) {
+        cout << "Window ramped from " << from << " to " << to
+             << " has size " << ramped.getWindowSize() << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Direct setters change the windows in use, but not the parameters that
+ * were prepared and not yet published.
+ */
+static bool directParametersKeepPreparedParameters()
+{
+    using Set = tdap::average::TrueFloatingPointWeightedMovingAverageSet<double, 20, 10>;
+    Set set(2000, 100000, 4, 0.0);
+    set.prepareUsedWindows(2);
+    set.prepareWindowSizeAndScale(1, 300, 2.0);
+    try {
+        // Window 3 is in use, although it is not in the prepared windows
+        set.setWindowSizeAndScale(3, 1800, 1.5);
+        set.setUsedWindows(3);
+    }
+    catch (const std::exception &e) {
+        cout << "Direct parameters rejected after preparing parameters: " << e.what() << endl;
+        return false;
+    }
+    if (set.getUsedWindows() != 3) {
+        cout << "Direct parameters not applied" << endl;
+        return false;
+    }
+    set.publishParameters();
+    set.adoptParameters();
+    if (set.getUsedWindows() != 2 || set.getWindowSize(0) != 500 ||
+        set.getWindowSize(1) != 300 || set.getWindowScale(1) != 2.0) {
+        cout << "Direct parameters changed prepared parameters" << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Ramps up after setWindowSize() made the active history smaller. The
+ * values that it did not keep must not reappear in the window.
+ */
+static bool rampAfterShrinkIgnoresDiscardedHistory(size_t rampSamples)
+{
+    DoubleAverage average(2000, 100000);
+    average.setAverage(0);
+    for (size_t i = 0; i < 3000; i++) {
+        average.addInput(1.0);
+    }
+    average.setWindowSize(100);
+    for (size_t i = 0; i < 1000; i++) {
+        average.addInput(0.0);
+    }
+    average.rampWindowSize(1000, rampSamples);
+    for (size_t i = 0; i < rampSamples + 1000; i++) {
+        average.addInput(0.0);
+        if (fabs(average.getAverage()) > 1e-9) {
+            cout << "Window ramped after shrinking history with " << rampSamples
+                 << " ramp samples has average " << average.getAverage()
+                 << " at sample " << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template<bool POWER2_HISTORY>
+static bool growAfterShrinkIgnoresDiscardedHistory()
+{
+    using Average = tdap::average::TrueFloatingPointWeightedMovingAverage<double, 20, 10, POWER2_HISTORY>;
+    Average average(2000, 100000);
+    average.setAverage(0);
+    for (size_t i = 0; i < 3000; i++) {
+        average.addInput(1.0);
+    }
+    average.setWindowSize(100);
+    for (size_t i = 0; i < 1000; i++) {
+        average.addInput(0.0);
+    }
+    average.setWindowSize(1000);
+    for (size_t i = 0; i < 2000; i++) {
+        average.addInput(0.0);
+        if (fabs(average.getAverage()) > 1e-9) {
+            cout << "Window grown after shrinking history (power of two " << POWER2_HISTORY
+                 << ") has average " << average.getAverage() << " at sample " << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template<bool POWER2_HISTORY>
+static bool resizingHistoryKeepsOtherWindows()
+{
+    static constexpr size_t SAMPLES = 4000;
+    using Set = tdap::average::TrueFloatingPointWeightedMovingAverageSet<double, 20, 10, POWER2_HISTORY>;
+    Set resized(2000, 100000, 2, 0.0);
+    Set reference(2000, 100000, 2, 0.0);
+    for (Set *set : {&resized, &reference}) {
+        set->setWindowSizeAndScale(0, 100, 1.0);
+        set->setWindowSizeAndScale(1, 1000, 1.0);
+    }
+    std::mt19937 random(SAMPLES);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        if (i == 1501) {
+            // Shrinks the history to fit the first window
+            resized.setWindowSizeAndScale(1, 50, 1.0);
+        }
+        else if (i == 2503) {
+            resized.setWindowSizeAndScale(1, 1000, 1.0);
+        }
+        double input = distribution(random);
+        resized.addInput(input);
+        reference.addInput(input);
+        if (resized.getAverage(0) != reference.getAverage(0)) {
+            cout << "Resizing history (power of two " << POWER2_HISTORY
+                 << ") changed other window at sample " << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool publishedParametersEqualDirectParameters()
+{
+    static constexpr size_t SAMPLES = 4000;
+    using Set = tdap::average::TrueFloatingPointWeightedMovingAverageSet<double, 20, 10>;
+    Set direct(2000, 100000, 4, 0.0);
+    Set published(2000, 100000, 4, 0.0);
+    std::mt19937 random(SAMPLES);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        if (i == SAMPLES / 4) {
+            direct.setUsedWindows(3);
+            direct.setWindowSizeAndScale(0, 100, 2.0);
+            direct.setWindowSizeAndScale(2, 700, 0.5);
+            published.prepareUsedWindows(3);
+            published.prepareWindowSizeAndScale(0, 100, 2.0);
+            published.prepareWindowSizeAndScale(2, 700, 0.5);
+            published.publishParameters();
+        }
+        else if (i == SAMPLES / 2) {
+            direct.setUsedWindows(4);
+            direct.setWindowSizeAndScale(3, 1800, 1.0);
+            published.prepareUsedWindows(4);
+            published.prepareWindowSizeAndScale(3, 1800, 1.0);
+            published.publishParameters();
+        }
+        bool adopted = published.adoptParameters();
+        if (adopted != (i == SAMPLES / 4 || i == SAMPLES / 2)) {
+            cout << "Published parameters adopted at wrong sample " << i << endl;
+            return false;
+        }
+        double input = distribution(random);
+        double expected = direct.addInputGetMax(input, 0.0);
+        if (published.addInputGetMax(input, 0.0) != expected ||
+            published.getUsedWindows() != direct.getUsedWindows()) {
+            cout << "Published parameters differ at sample " << i << endl;
+            return false;
+        }
+        for (size_t window = 0; window < direct.getUsedWindows(); window++) {
+            if (published.getAverage(window) != direct.getAverage(window)) {
+                cout << "Published parameters differ at sample " << i
+                     << " for window " << window << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool slidingExtremaEqualWindowExtrema(size_t windowSize)
+{
+    static constexpr size_t SAMPLES = 5000;
+    static constexpr size_t BLOCK = 10;
+    tdap::peak::SlidingWindowMax<double> maximum(windowSize);
+    tdap::peak::SlidingWindowMin<int> minimum(windowSize);
+    if (maximum.getValue() != 0 || minimum.getValue() != 0) {
+        cout << "Sliding extrema (window " << windowSize << ") do not start at zero" << endl;
+        return false;
+    }
+    maximum.setValue(-2.0);
+    minimum.setValue(2000);
+    std::mt19937 random(windowSize);
+    std::uniform_int_distribution<int> distribution(-1000, 1000);
+    std::vector<int> input(SAMPLES);
+    for (int &value : input) {
+        // Few distinct values, so that equal values occur
+        value = distribution(random) / 100;
+    }
+    const size_t smallerWindowSize = windowSize / 2 + 1;
+    double block[BLOCK];
+    for (size_t i = 0; i < SAMPLES; i += BLOCK) {
+        if (i == SAMPLES / 2) {
+            maximum.setWindowSize(smallerWindowSize);
+            minimum.setWindowSize(smallerWindowSize);
+        }
+        for (size_t j = 0; j < BLOCK; j++) {
+            block[j] = input[i + j];
+        }
+        maximum.addInputs(block, block, BLOCK);
+        for (size_t j = i; j < i + BLOCK; j++) {
+            const int actualMinimum = minimum.addInput(input[j]);
+            const size_t samples = maximum.getWindowSize();
+            double expectedMaximum = j >= samples - 1 ? -1e100 : -2.0;
+            int expectedMinimum = j >= samples - 1 ? 1000000 : 2000;
+            for (size_t k = 0; k < samples && k <= j; k++) {
+                expectedMaximum = std::max(expectedMaximum, static_cast<double>(input[j - k]));
+                expectedMinimum = std::min(expectedMinimum, input[j - k]);
+            }
+            if (block[j - i] != expectedMaximum || actualMinimum != expectedMinimum) {
+                cout << "Sliding window (" << samples << ") extrema " << block[j - i] << ", "
+                     << actualMinimum << " instead of " << expectedMaximum << ", "
+                     << expectedMinimum << " at sample " << j << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool bucketAverageEqualsBucketSums(size_t bucketSize, size_t bucketCount)
+{
+    static constexpr size_t SAMPLES = 20000;
+    static constexpr size_t BLOCK = 37;
+    static constexpr double SCALE = 2.0;
+    static constexpr double INITIAL = 0.25;
+    tdap::average::BucketAverage<double, 16> average;
+    average.setBucketSizeAndCount(bucketSize, bucketCount);
+    average.setOutputScale(SCALE);
+    average.setAverage(INITIAL);
+    const size_t windowSize = bucketSize * bucketCount;
+    std::mt19937 random(windowSize);
+    std::uniform_real_distribution<double> distribution(0, 1);
+    std::vector<double> input(SAMPLES);
+    for (double &value : input) {
+        value = distribution(random);
+    }
+    std::vector<double> output(input);
+    for (size_t i = 0; i < SAMPLES; i += BLOCK) {
+        const size_t block = std::min(BLOCK, SAMPLES - i);
+        if (i < SAMPLES / 2) {
+            average.addInputs(output.data() + i, output.data() + i, block);
+        }
+        else for (size_t j = i; j < i + block; j++) {
+            output[j] = average.addInputGetAverage(input[j]);
+        }
+    }
+    // Recalculate all bucket sums for each sample
+    std::vector<double> buckets(bucketCount, INITIAL * bucketSize);
+    size_t current = 0;
+    double partial = 0;
+    size_t remaining = bucketSize;
+    double fill = INITIAL;
+    for (size_t i = 0; i < SAMPLES; i++) {
+        partial += input[i];
+        remaining--;
+        double sum = partial + remaining * fill;
+        for (size_t bucket = 0; bucket < bucketCount; bucket++) {
+            if (bucket != current) {
+                sum += buckets[bucket];
+            }
+        }
+        const double expected = SCALE * sum / windowSize;
+        if (fabs(output[i] - expected) > 1e-12 * expected) {
+            cout << "Bucket average (" << bucketSize << " x " << bucketCount << ") "
+                 << output[i] << " instead of " << expected << " at sample " << i << endl;
+            return false;
+        }
+        if (remaining == 0) {
+            fill = sum / windowSize;
+            buckets[current] = partial;
+            current = (current + 1) % bucketCount;
+            partial = 0;
+            remaining = bucketSize;
+        }
+    }
+    tdap::average::BucketRms<double, 16> rms;
+    const size_t rmsWindowSize = rms.setApproximateWindowSize(windowSize);
+    if (rmsWindowSize > windowSize || 100 * (windowSize - rmsWindowSize) >= windowSize) {
+        cout << "Bucket RMS window size " << rmsWindowSize << " not close to " << windowSize << endl;
+        return false;
+    }
+    for (size_t i = 0; i < rmsWindowSize; i++) {
+        rms.addInputGetRms(i % 2 ? -0.5 : 0.5);
+    }
+    if (fabs(rms.getRms() - 0.5) > 1e-12) {
+        cout << "Bucket RMS " << rms.getRms() << " instead of 0.5" << endl;
+        return false;
+    }
+    return true;
+}
+
+template<size_t LEVELS>
+static bool perceptiveRmsEqualsBucketAverages(size_t levels, double biggestWindowSeconds)
+{
+    static constexpr size_t BUCKETS = 16;
+    static constexpr size_t SAMPLES = 50000;
+    static constexpr double SAMPLE_RATE = 8000;
+    using Detector = tdap::average::PerceptiveRms<double, BUCKETS, LEVELS>;
+    using Average = tdap::average::BucketAverage<double, BUCKETS>;
+    Detector detector;
+    detector.configure(SAMPLE_RATE, biggestWindowSeconds, 4, levels);
+    detector.setRms(0.5);
+    std::vector<Average> averages(detector.getUsedLevels());
+    for (size_t level = 0; level < averages.size(); level++) {
+        const double scale = detector.getScale(level);
+        averages[level].setBucketSizeAndCount(detector.getBucketSize(level), detector.getBucketCount(level));
+        averages[level].setOutputScale(scale * scale);
+        averages[level].setAverage(0.25);
+        if (level > 0 && detector.getWindowSize(level) <= detector.getWindowSize(level - 1)) {
+            cout << "Perceptive RMS window " << level << " is not bigger than previous" << endl;
+            return false;
+        }
+    }
+    tdap::integration::SmoothHoldMaxAttackRelease<double> follower(
+            Detector::PEAK_HOLD_SECONDS * SAMPLE_RATE,
+            0.5 + 0.5 * Detector::PEAK_SECONDS * SAMPLE_RATE,
+            Detector::PEAK_RELEASE_SECONDS * SAMPLE_RATE);
+    follower.setOutput(0.5);
+    std::mt19937 random(levels);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    std::vector<double> squares(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        // Alternate loud and quiet parts
+        const double value = distribution(random) * ((i / 3000) % 2 ? 0.1 : 1.0);
+        squares[i] = value * value;
+    }
+    std::vector<double> detections(SAMPLES);
+    detector.addSquares(squares.data(), detections.data(), SAMPLES / 2);
+    for (size_t i = SAMPLES / 2; i < SAMPLES; i++) {
+        detections[i] = detector.addSquareGetDetection(squares[i]);
+    }
+    for (size_t i = 0; i < SAMPLES; i++) {
+        double maximum = 0;
+        for (Average &average : averages) {
+            maximum = std::max(maximum, average.addInputGetAverage(squares[i]));
+        }
+        const double expected = follower.integrate(sqrt(maximum));
+        if (detections[i] != expected) {
+            cout << "Perceptive RMS (" << levels << " levels) detection " << detections[i]
+                 << " instead of " << expected << " at sample " << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template<size_t CHANNELS>
+static bool linkedPerceptiveRmsEqualsRmsOfLinkedSquares(tdap::average::ChannelLink link)
+{
+    static constexpr size_t FRAMES = 10000;
+    static constexpr double SAMPLE_RATE = 8000;
+    tdap::average::LinkedPerceptiveRms<double, CHANNELS, 16, 8> linked;
+    tdap::average::PerceptiveRms<double, 16, 8> detector;
+    linked.configure(SAMPLE_RATE, 1.0, 4);
+    detector.configure(SAMPLE_RATE, 1.0, 4);
+    linked.setLink(link);
+    std::mt19937 random(CHANNELS);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+    std::vector<double> input(FRAMES * CHANNELS);
+    for (double &value : input) {
+        value = distribution(random);
+    }
+    std::vector<double> detections(FRAMES);
+    linked.addFrames(input.data(), detections.data(), FRAMES);
+    for (size_t frame = 0; frame < FRAMES; frame++) {
+        double square = 0;
+        for (size_t channel = 0; channel < CHANNELS; channel++) {
+            const double value = input[frame * CHANNELS + channel];
+            square = link == tdap::average::ChannelLink::MAXIMUM
+                     ? std::max(square, value * value)
+                     : square + value * value;
+        }
+        const double expected = detector.addSquareGetDetection(square);
+        if (detections[frame] != expected) {
+            cout << "Linked perceptive RMS (" << CHANNELS << " channels) detection "
+                 << detections[frame] << " instead of " << expected << " at frame " << frame << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool multiRateAverageSetFollowsFullRateSet()
+{
+    static constexpr size_t SAMPLES = 40000;
+    static constexpr size_t DECIMATION = 16;
+    static constexpr size_t EMD = 80000;
+    static constexpr size_t WINDOWS[4] = {100, 400, 2000, 8000};
+    static constexpr double SCALES[4] = {0.6, 0.8, 0.9, 1.0};
+    using Set = tdap::average::TrueFloatingPointWeightedMovingAverageSet<double, 20, 10>;
+    using MultiRateSet = tdap::average::MultiRateMovingAverageSet<double, DECIMATION, 20, 10>;
+    Set set(8000, EMD, 4, 0.5);
+    MultiRateSet multiRate(400, 8000, EMD, 2, 2, 0.5);
+    for (size_t i = 0; i < 4; i++) {
+        set.setWindowSizeAndScale(i, WINDOWS[i], SCALES[i]);
+        multiRate.setWindowSizeAndScale(i, WINDOWS[i], SCALES[i]);
+    }
+    set.setAverages(0.5);
+    multiRate.setAverages(0.5);
+    std::mt19937 random(SAMPLES);
+    std::uniform_real_distribution<double> distribution(0, 1);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        // A level that changes slowly, with noise
+        const double level = 0.5 + 0.4 * sin(i * 0.0005);
+        const double input = level * distribution(random);
+        const double expected = set.addInputGetMax(input, 0);
+        const double actual = multiRate.addInputGetMax(input, 0);
+        if (fabs(actual - expected) > 0.01) {
+            cout << "Multi-rate average set maximum " << actual << " instead of "
+                 << expected << " at sample " << i << endl;
+            return false;
+        }
+        if ((i + 1) % DECIMATION == 0) {
+            for (size_t window = 0; window < 4; window++) {
+                const double maximumError = window < 2 ? 1e-9 : 1e-3;
+                if (fabs(multiRate.getAverage(window) - set.getAverage(window)) > maximumError) {
+                    cout << "Multi-rate average set window " << window << " average "
+                         << multiRate.getAverage(window) << " instead of "
+                         << set.getAverage(window) << " at sample " << i << endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template<class ARRAY>
+static bool bufferIsAlignedAndPadded(const ARRAY &array, const char *name)
+{
+    const size_t address = reinterpret_cast<size_t>(array.data());
+    const size_t paddedBytes = array.paddedSize() * sizeof(array[0]);
+    if (address % tdap::BUFFER_ALIGNMENT != 0 || paddedBytes % tdap::BUFFER_ALIGNMENT != 0 ||
+        array.paddedSize() < array.size()) {
+        cout << name << " of size " << array.size() << " not aligned or padded" << endl;
+        return false;
+    }
+    return true;
+}
+
+static bool buffersAreAlignedAndCopy(size_t size)
+{
+    tdap::Buffer<double> buffer(size);
+    tdap::Buffer<float> floats(size, 0.5f);
+    tdap::Array<double, 37> array;
+    bool success = bufferIsAlignedAndPadded(buffer, "Buffer<double>") &&
+                   bufferIsAlignedAndPadded(floats, "Buffer<float>") &&
+                   bufferIsAlignedAndPadded(array, "Array<double, 37>");
+    for (size_t i = 0; i < size; i++) {
+        success &= buffer[i] == 0.0 && floats[i] == 0.5f;
+        buffer[i] = i;
+    }
+    tdap::Buffer<double> copy(buffer);
+    tdap::Buffer<double> moved(std::move(copy));
+    for (size_t i = 0; i < size; i++) {
+        success &= moved[i] == i;
+    }
+    success &= copy.data() == nullptr && copy.size() == 0;
+    // Overlapping move towards the end, then copy a range into the array
+    moved.move(1, 0, size - 1);
+    array.fill(-1);
+    array.copy(1, moved, 2, 10);
+    for (size_t i = 0; i < array.size(); i++) {
+        const double expected = i >= 1 && i <= 10 ? static_cast<double>(i) : -1.0;
+        success &= array[i] == expected;
+    }
+    moved.zero();
+    moved.copy(buffer);
+    for (size_t i = 0; i < size; i++) {
+        success &= moved[i] == buffer[i];
+    }
+    try {
+        array.copy(buffer);
+        success = false;
+    }
+    catch (const std::invalid_argument &) {
+    }
+    try {
+        array.copy(30, buffer, 0, 10);
+        success = false;
+    }
+    catch (const std::out_of_range &) {
+    }
+    if (!success) {
+        cout << "Buffers of size " << size << " do not fill, copy or move correctly" << endl;
+    }
+    return success;
+}
+
+static bool lookAheadLimiterLimitsDelayedInput(size_t lookAhead)
+{
+    static constexpr size_t CHANNELS = 2;
+    static constexpr size_t FRAMES = 20000;
+    static constexpr size_t BLOCK = 64;
+    static constexpr double THRESHOLD = 0.5;
+    tdap::peak::LookAheadLimiter<double, CHANNELS> limiter(100);
+    limiter.setLookAhead(lookAhead);
+    limiter.setThreshold(THRESHOLD);
+    limiter.setReleaseSamples(100);
+    if (limiter.getLatency() != lookAhead) {
+        cout << "Look-ahead limiter reports latency " << limiter.getLatency()
+             << " instead of " << lookAhead << endl;
+        return false;
+    }
+    std::mt19937 random(lookAhead);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    std::vector<double> input(FRAMES * CHANNELS);
+    for (size_t i = 0; i < input.size(); i++) {
+        // Alternate loud and quiet passages
+        input[i] = distribution(random) * ((i / CHANNELS / 1500) % 2 ? 0.1 : 2.0);
+    }
+    std::vector<double> output(FRAMES * CHANNELS);
+    for (size_t frame = 0; frame < FRAMES; frame += BLOCK) {
+        limiter.process(input.data() + frame * CHANNELS, output.data() + frame * CHANNELS,
+                        std::min(BLOCK, FRAMES - frame));
+    }
+    for (size_t i = 0; i < output.size(); i++) {
+        const double delayed = i >= lookAhead * CHANNELS ? input[i - lookAhead * CHANNELS] : 0.0;
+        const double gain = delayed != 0 ? output[i] / delayed : 1.0;
+        if (fabs(output[i]) > THRESHOLD * (1 + 1e-12) || gain < 0 || gain > 1 + 1e-12) {
+            cout << "Look-ahead limiter (look-ahead " << lookAhead << ") output " << output[i]
+                 << " for delayed input " << delayed << " at sample " << i << endl;
+            return false;
+        }
+    }
+    // Quiet passages are eventually passed unchanged
+    const size_t quiet = 2999;
+    if (fabs(output[quiet * CHANNELS] - input[(quiet - lookAhead) * CHANNELS]) > 1e-6) {
+        cout << "Look-ahead limiter (look-ahead " << lookAhead << ") does not release" << endl;
+        return false;
+    }
+    return true;
+}
+
+static bool filterChainEqualsSequentialFilters()
+{
+    using Biquad = tdap::filter::Biquad<double>;
+    using Chain = tdap::filter::FilterChain<double, Biquad, Biquad, Biquad>;
+    Biquad highPass = Biquad::highPass(48000, 20, 0.7);
+    Biquad peaking = Biquad::peaking(48000, 1000, 2.0, 3.0);
+    Biquad lowPass = Biquad::lowPass(48000, 10000, 0.7);
+    Chain chain(highPass, peaking, lowPass);
+    tdap::filter::FilterAdapter<double, Chain> adapter(chain);
+    DoubleFilter &adapted = adapter;
+    std::mt19937 random(Chain::size());
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    for (size_t i = 0; i < 1000; i++) {
+        double input = distribution(random);
+        double expected = lowPass.filter(peaking.filter(highPass.filter(input)));
+        if (chain.filter(input) != expected || adapted.filter(input) != expected) {
+            cout << "Filter chain differs from sequential filters at sample "
+                 << i << endl;
+            return false;
+        }
+    }
+    Chain fresh(
+            Biquad::highPass(48000, 20, 0.7),
+            Biquad::peaking(48000, 1000, 2.0, 3.0),
+            Biquad::lowPass(48000, 10000, 0.7));
+    adapted.reset();
+    if (adapted.filter(1.0) != fresh.filter(1.0)) {
+        cout << "Filter chain reset does not reset all filters" << endl;
+        return false;
+    }
+    return true;
+}
+
+static bool blockFilterEqualsPerSampleFilter()
+{
+    using Biquad = tdap::filter::Biquad<double>;
+    static constexpr size_t SAMPLES = 1000;
+    tdap::filter::FilterAdapter<double, Biquad> adapter(
+            Biquad::peaking(48000, 1000, 2.0, 3.0));
+    Biquad biquad = Biquad::peaking(48000, 1000, 2.0, 3.0);
+    DoubleFilter &filter = adapter;
+    std::vector<double> input(SAMPLES);
+    std::vector<double> output(SAMPLES);
+    std::vector<double> identity(SAMPLES);
+    std::mt19937 random(SAMPLES);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    for (double &value : input) {
+        value = distribution(random);
+    }
+    // Has no block method, so the adapter filters blocks per sample
+    struct Half
+    {
+        double filter(const double input) { return 0.5 * input; }
+        void reset() { }
+    };
+    tdap::filter::FilterAdapter<double, Half> half;
+    std::vector<double> halved(SAMPLES);
+    filter.filter(input.data(), output.data(), SAMPLES);
+    DoubleFilter::identity().filter(input.data(), identity.data(), SAMPLES);
+    half.filter(input.data(), halved.data(), SAMPLES);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        if (output[i] != biquad.filter(input[i]) || identity[i] != input[i] ||
+            halved[i] != 0.5 * input[i]) {
+            cout << "Block filter differs from per sample filter at sample "
+                 << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool fastImpulseResponseLengthEqualsLength()
+{
+    using Biquad = tdap::filter::Biquad<double>;
+    using Chain = tdap::filter::FilterChain<double, Biquad, Biquad>;
+    // Hides the pole radius, so the fast measurement cannot use it
+    struct Unknown : public DoubleFilter
+    {
+        DoubleFilter &filter_;
+        explicit Unknown(DoubleFilter &filter) : filter_(filter) {}
+        using DoubleFilter::filter;
+        double filter(const double input) override { return filter_.filter(input); }
+        void reset() override { filter_.reset(); }
+    };
+    for (double q : {0.5, 5.0, 50.0}) {
+        tdap::filter::FilterAdapter<double, Chain> adapter(Chain(
+                Biquad::lowPass(48000, 100, q),
+                Biquad::peaking(48000, 1000, q, 6.0)));
+        Unknown unknown(adapter);
+        ssize_t expected = DoubleFilter::getEffectiveImpulseResponseLength(
+                adapter, 1000000, 1e-6, 100);
+        adapter.reset();
+        ssize_t fast = DoubleFilter::getEffectiveImpulseResponseLengthFast(
+                adapter, 1000000, 1e-6, 100);
+        adapter.reset();
+        ssize_t fastUnknown = DoubleFilter::getEffectiveImpulseResponseLengthFast(
+                unknown, 1000000, 1e-6, 100);
+        adapter.reset();
+        if (expected < 0 || fast != expected || fastUnknown != expected) {
+            cout << "Fast impulse response length for q=" << q << " is " << fast
+                 << " and " << fastUnknown << " instead of " << expected << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parallelImpulseResponseLengthsAreInOrder()
+{
+    using Biquad = tdap::filter::Biquad<double>;
+    using Adapter = tdap::filter::FilterAdapter<double, Biquad>;
+    std::vector<std::unique_ptr<Adapter>> bank;
+    std::vector<const DoubleFilter *> filters;
+    for (size_t i = 0; i < 40; i++) {
+        bank.emplace_back(new Adapter(Biquad::peaking(48000, 100 + 50 * i, 1.0 + i, 6.0)));
+        filters.push_back(bank.back().get());
+    }
+    tdap::filter::FilterClone<double> clone = [](const DoubleFilter &filter) {
+        return std::unique_ptr<DoubleFilter>(new Adapter(static_cast<const Adapter &>(filter)));
+    };
+    std::vector<ssize_t> lengths = tdap::filter::getEffectiveImpulseResponseLengths(
+            filters, clone, 1000000, 1e-6, 100, 4);
+    for (size_t i = 0; i < bank.size(); i++) {
+        Adapter copy(*bank[i]);
+        ssize_t expected = DoubleFilter::getEffectiveImpulseResponseLength(
+                copy, 1000000, 1e-6, 100);
+        if (lengths[i] != expected) {
+            cout << "Parallel impulse response length of filter " << i << " is "
+                 << lengths[i] << " instead of " << expected << endl;
+            return false;
+        }
+    }
+    tdap::filter::FilterClone<double> noClone = [](const DoubleFilter &) {
+        return std::unique_ptr<DoubleFilter>();
+    };
+    try {
+        tdap::filter::getEffectiveImpulseResponseLengths(filters, noClone, 1000000, 1e-6, 100, 4);
+        cout << "Parallel impulse response lengths accept empty clones" << endl;
+        return false;
+    }
+    catch (const std::invalid_argument &) {
+    }
+    try {
+        filters.push_back(nullptr);
+        tdap::filter::getEffectiveImpulseResponseLengths(filters, clone, 1000000, 1e-6, 100, 4);
+        cout << "Parallel impulse response lengths accept null filters" << endl;
+        return false;
+    }
+    catch (const std::invalid_argument &) {
+    }
+    return true;
+}
+
+static bool channelViewsUseTheirChannel()
+{
+    // Multiplies each channel with its number plus one
+    struct Gains : public DoubleChannelFilter
+    {
+        size_t getChannels() const override { return 3; }
+
+        using DoubleChannelFilter::filter;
+
+        double filter(const size_t channel, const double input) override
+        {
+            return input * (channel + 1);
+        }
+    };
+    Gains gains;
+    tdap::filter::ChannelFilterView<double> single = gains.single();
+    tdap::filter::ChannelFilterView<double> last = gains.channel(2);
+    DoubleFilter &filter = last;
+    double block[] = {1.0, 2.0};
+    double frame[] = {1.0, 1.0, 1.0};
+    filter.filter(block, block, 2);
+    gains.filter(frame, frame, 1);
+    if (single.filter(2.0) != 2.0 || filter.filter(2.0) != 6.0 || block[1] != 6.0 ||
+        frame[2] != 3.0) {
+        cout << "Channel filter views do not use their channel" << endl;
+        return false;
+    }
+    try {
+        gains.channel(3);
+        cout << "Channel filter view accepts invalid channel" << endl;
+        return false;
+    }
+    catch (const std::out_of_range &) {
+    }
+    return true;
+}
 
 int main ()
 {
     cout << "Hello world!" << endl;
 
+    bool success = true;
+    for (size_t windowSize : {64, 100, 1000}) {
+        for (size_t blockSize : {1, 7, 64, 256, 1024}) {
+            success &= blockAverageEqualsPerSampleAverage(windowSize, blockSize, false);
+            success &= blockAverageEqualsPerSampleAverage(windowSize, blockSize, true);
+        }
+    }
+    for (size_t windowSize : {64, 1500, 2000}) {
+        success &= multiChannelAverageEqualsSingleChannelAverages(windowSize);
+        success &= fixedCapacityAverageEqualsDynamicAverage<true>(windowSize);
+        success &= fixedCapacityAverageEqualsDynamicAverage<false>(windowSize);
+        success &= power2HistoryAverageEqualsAverage(windowSize);
+    }
+    for (size_t rampSamples : {0, 1, 1000}) {
+        for (size_t blockSize : {1, 64}) {
+            success &= rampedWindowEqualsFixedWindow(1500, 300, rampSamples, blockSize);
+            success &= rampedWindowEqualsFixedWindow(300, 1500, rampSamples, blockSize);
+        }
+        success &= rampAfterShrinkIgnoresDiscardedHistory(rampSamples);
+    }
+    success &= growAfterShrinkIgnoresDiscardedHistory<false>();
+    success &= growAfterShrinkIgnoresDiscardedHistory<true>();
+    success &= resizingHistoryKeepsOtherWindows<false>();
+    success &= resizingHistoryKeepsOtherWindows<true>();
+    success &= publishedParametersEqualDirectParameters();
+    success &= directParametersKeepPreparedParameters();
+    for (size_t windowSize : {1, 64, 4800, 100000}) {
+        success &= compensatedFloatAverageIsPrecise(windowSize);
+    }
+    for (size_t windowSize : {1, 64, 1500}) {
+        // Fewer windows than vector lanes of the maximum and more
+        for (size_t windows : {5, 11}) {
+            success &= preciseAveragesAreExact(windowSize, windows);
+        }
+    }
+    for (size_t windowSize : {1, 64, 1000}) {
+        for (size_t blockSize : {1, 100}) {
+            success &= resynchronisingAverageIsPrecise(windowSize, blockSize);
+        }
+    }
+    for (size_t maxWindowSize : {1, 2, 3, 64, 1000}) {
+        success &= windowSumTreeEqualsWindowSums<int64_t>(maxWindowSize);
+        success &= windowSumTreeEqualsWindowSums<double>(maxWindowSize);
+    }
+    for (size_t windows : {1, 3, 8, 11, 32}) {
+        success &= averageSetEqualsSeparateAverages<false>(windows);
+        success &= averageSetEqualsSeparateAverages<true>(windows);
+    }
+    success &= lazyAverageSetEqualsAverageSet();
+    success &= lazyAverageSetIsPreciseForLongDecays();
+    success &= multiRateAverageSetFollowsFullRateSet();
+    for (size_t windowSize : {1, 2, 5, 64, 1000}) {
+        success &= slidingExtremaEqualWindowExtrema(windowSize);
+    }
+    for (size_t lookAhead : {0, 1, 10, 100}) {
+        success &= lookAheadLimiterLimitsDelayedInput(lookAhead);
+    }
+    for (size_t bucketSize : {1, 7, 100}) {
+        for (size_t bucketCount : {2, 5, 16}) {
+            success &= bucketAverageEqualsBucketSums(bucketSize, bucketCount);
+        }
+    }
+    success &= perceptiveRmsEqualsBucketAverages<3>(3, 0.4);
+    success &= perceptiveRmsEqualsBucketAverages<8>(5, 2.0);
+    success &= perceptiveRmsEqualsBucketAverages<16>(16, 5.0);
+    success &= perceptiveRmsEqualsBucketAverages<16>(11, 0.5);
+    for (auto link : {tdap::average::ChannelLink::MAXIMUM, tdap::average::ChannelLink::SUM}) {
+        success &= linkedPerceptiveRmsEqualsRmsOfLinkedSquares<1>(link);
+        success &= linkedPerceptiveRmsEqualsRmsOfLinkedSquares<2>(link);
+        success &= linkedPerceptiveRmsEqualsRmsOfLinkedSquares<8>(link);
+    }
+    for (size_t size : {12, 33, 1000}) {
+        success &= buffersAreAlignedAndCopy(size);
+    }
+    success &= filterChainEqualsSequentialFilters();
+    success &= blockFilterEqualsPerSampleFilter();
+    success &= fastImpulseResponseLengthEqualsLength();
+    success &= parallelImpulseResponseLengthsAreInOrder();
+    success &= channelViewsUseTheirChannel();
+
     cout
     <<
     "Effective length of identity filter is "
     << DoubleFilter::getEffectiveImpulseResponseLength(
             DoubleFilter::identity(), 1000, 1e-12, 100) << endl;
 
-    return 0;
+    return success ? 0 : 1;
 }